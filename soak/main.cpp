@@ -0,0 +1,505 @@
+/*
+ * spindash_soak - headless mass-simulation driver
+ *
+ * Runs a large number of characters with scripted or random input over
+ * generated terrain, using nothing but the public C API. There is no
+ * renderer and no SDL dependency so this can run on build machines.
+ *
+ * At the end of the run (and every --report-every steps) it prints the
+ * throughput, step latency percentiles, peak RSS and the number of NaN
+ * and tunnelling incidents that were detected.
+ *
+ * With --box-stack N it instead drops N boxes in stacked columns onto a
+ * flat floor and runs until they have all settled and gone to sleep.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <sys/resource.h>
+
+#include "spindash/spindash.h"
+
+namespace {
+
+const SDfloat FRAME_TIME = 1.0f / 60.0f;
+
+//Characters are one unit high, so the sensors need scaling down to match
+const SDfloat SENSOR_EXTENSION = 16.0f / 40.0f;
+
+const SDfloat TERRAIN_SEGMENT_WIDTH = 2.0f;
+const SDfloat TERRAIN_MAX_SLOPE = 0.75f;
+const SDfloat TERRAIN_DEPTH = 5.0f;
+const SDfloat TERRAIN_WALL_HEIGHT = 50.0f;
+
+//How far below the surface a character can be before we count it as tunnelled
+const SDfloat TUNNEL_TOLERANCE = 0.5f;
+
+enum InputMode {
+    INPUT_MODE_RANDOM,
+    INPUT_MODE_SCRIPTED
+};
+
+struct Options {
+    SDuint characters = 1000;
+    SDuint64 steps = 1000000;
+    SDuint terrain_segments = 2000;
+    SDuint64 report_every = 0;
+    SDuint seed = 1;
+    InputMode input_mode = INPUT_MODE_RANDOM;
+    SDuint box_stack = 0;
+};
+
+const SDuint BOX_STACK_HEIGHT = 25;
+const SDfloat BOX_SIZE = 1.0f;
+
+struct Terrain {
+    SDfloat left = 0;
+    std::vector<SDfloat> heights;
+
+    SDfloat right() const {
+        return left + (heights.size() - 1) * TERRAIN_SEGMENT_WIDTH;
+    }
+
+    SDfloat height_at(SDfloat x) const {
+        SDfloat offset = (x - left) / TERRAIN_SEGMENT_WIDTH;
+        if(offset <= 0) return heights.front();
+
+        SDuint i = SDuint(offset);
+        if(i >= heights.size() - 1) return heights.back();
+
+        SDfloat t = offset - SDfloat(i);
+        return heights[i] + (heights[i + 1] - heights[i]) * t;
+    }
+};
+
+struct Controller {
+    SDuint character = 0;
+    SDint direction = 0;
+    SDuint hold_frames = 0;
+    bool jumping = false;
+};
+
+//Step latencies from 0.1us to 100s land in buckets 1% wide, anything outside goes in the end buckets
+const double LATENCY_MIN_US = 0.1;
+const double LATENCY_MAX_US = 100000000.0;
+const double LATENCY_BUCKET_GROWTH = 1.01;
+
+/*
+ * Counts step latencies in fixed buckets, so the memory used doesn't grow with
+ * the number of steps and a percentile is one walk over the buckets. They
+ * come back accurate to a bucket, which is 1%.
+ */
+class LatencyHistogram {
+public:
+    LatencyHistogram():
+        buckets_(bucket_for(LATENCY_MAX_US) + 1, 0) {}
+
+    void add(double microseconds) {
+        ++buckets_[bucket_for(microseconds)];
+        ++count_;
+    }
+
+    double percentile(double p) const {
+        if(!count_) return 0;
+
+        SDuint64 rank = std::min<SDuint64>(count_ - 1, SDuint64(p * (count_ - 1) + 0.5));
+        SDuint64 seen = 0;
+        for(size_t i = 0; i < buckets_.size(); ++i) {
+            seen += buckets_[i];
+            if(seen > rank) {
+                return LATENCY_MIN_US * std::pow(LATENCY_BUCKET_GROWTH, double(i)); //The bottom of the bucket
+            }
+        }
+
+        return LATENCY_MAX_US;
+    }
+
+private:
+    std::vector<SDuint64> buckets_;
+    SDuint64 count_ = 0;
+
+    static size_t bucket_for(double microseconds) {
+        if(microseconds <= LATENCY_MIN_US) return 0;
+
+        double bucket = std::log(std::min(microseconds, LATENCY_MAX_US) / LATENCY_MIN_US) / std::log(LATENCY_BUCKET_GROWTH);
+        return size_t(bucket);
+    }
+};
+
+struct Stats {
+    SDuint64 nan_incidents = 0;
+    SDuint64 tunnel_incidents = 0;
+    LatencyHistogram step_latencies; //Microseconds
+    double total_seconds = 0;
+};
+
+void print_usage(const char* program) {
+    std::printf(
+        "Usage: %s [options]\n"
+        "  --characters N     Number of characters to simulate (default 1000)\n"
+        "  --steps N          Number of world steps to run (default 1000000)\n"
+        "  --segments N       Number of terrain segments to generate (default 2000)\n"
+        "  --input MODE       'random' or 'scripted' (default random)\n"
+        "  --seed N           Seed for terrain and input generation (default 1)\n"
+        "  --report-every N   Print intermediate stats every N steps\n"
+        "  --box-stack N      Settle a stack of N boxes instead of running characters\n",
+        program
+    );
+}
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for(int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if(arg == "--help" || arg == "-h") {
+            return false;
+        } else if(arg == "--characters" && has_value) {
+            options.characters = std::strtoul(argv[++i], nullptr, 10);
+        } else if(arg == "--steps" && has_value) {
+            options.steps = std::strtoull(argv[++i], nullptr, 10);
+        } else if(arg == "--segments" && has_value) {
+            options.terrain_segments = std::max<SDuint>(2, std::strtoul(argv[++i], nullptr, 10));
+        } else if(arg == "--seed" && has_value) {
+            options.seed = std::strtoul(argv[++i], nullptr, 10);
+        } else if(arg == "--box-stack" && has_value) {
+            options.box_stack = std::strtoul(argv[++i], nullptr, 10);
+        } else if(arg == "--report-every" && has_value) {
+            options.report_every = std::strtoull(argv[++i], nullptr, 10);
+        } else if(arg == "--input" && has_value) {
+            std::string mode = argv[++i];
+            if(mode == "random") {
+                options.input_mode = INPUT_MODE_RANDOM;
+            } else if(mode == "scripted") {
+                options.input_mode = INPUT_MODE_SCRIPTED;
+            } else {
+                std::fprintf(stderr, "Unknown input mode: %s\n", mode.c_str());
+                return false;
+            }
+        } else {
+            std::fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Generates a rolling heightfield out of quads (two triangles each) that go down to
+ * a flat base, and puts a tall wall at either end so characters can't run off.
+ */
+Terrain build_terrain(SDuint world, SDuint segments, std::mt19937& rng) {
+    std::uniform_real_distribution<SDfloat> slope(-TERRAIN_MAX_SLOPE, TERRAIN_MAX_SLOPE);
+
+    Terrain terrain;
+    terrain.left = -(segments * TERRAIN_SEGMENT_WIDTH) * 0.5f;
+    terrain.heights.push_back(0);
+
+    for(SDuint i = 0; i < segments; ++i) {
+        SDfloat next = terrain.heights.back() + slope(rng) * TERRAIN_SEGMENT_WIDTH;
+        terrain.heights.push_back(next);
+    }
+
+    SDfloat base = *std::min_element(terrain.heights.begin(), terrain.heights.end()) - TERRAIN_DEPTH;
+
+    std::vector<kmVec2> points;
+    points.reserve(segments * 6);
+    for(SDuint i = 0; i < segments; ++i) {
+        SDfloat x0 = terrain.left + i * TERRAIN_SEGMENT_WIDTH;
+        SDfloat x1 = x0 + TERRAIN_SEGMENT_WIDTH;
+        SDfloat y0 = terrain.heights[i];
+        SDfloat y1 = terrain.heights[i + 1];
+
+        kmVec2 tmp;
+        points.push_back(*kmVec2Fill(&tmp, x0, y0));
+        points.push_back(*kmVec2Fill(&tmp, x0, base));
+        points.push_back(*kmVec2Fill(&tmp, x1, y1));
+
+        points.push_back(*kmVec2Fill(&tmp, x1, y1));
+        points.push_back(*kmVec2Fill(&tmp, x0, base));
+        points.push_back(*kmVec2Fill(&tmp, x1, base));
+    }
+
+    sdWorldAddMesh(world, segments * 2, &points[0]);
+
+    //Left edge of each wall
+    SDfloat walls[2] = { terrain.left - 1.0f, terrain.right() };
+    for(SDfloat wall_left: walls) {
+        kmVec2 wall[4];
+        kmVec2Fill(&wall[0], wall_left, base);
+        kmVec2Fill(&wall[1], wall_left + 1.0f, base);
+        kmVec2Fill(&wall[2], wall_left + 1.0f, base + TERRAIN_WALL_HEIGHT);
+        kmVec2Fill(&wall[3], wall_left, base + TERRAIN_WALL_HEIGHT);
+        sdWorldAddBox(world, wall);
+    }
+
+    return terrain;
+}
+
+void place_on_terrain(SDuint character, SDfloat x, const Terrain& terrain) {
+    sdObjectSetPosition(character, x, terrain.height_at(x) + 1.0f);
+    sdObjectSetSpeedX(character, 0);
+    sdObjectSetSpeedY(character, 0);
+    sdCharacterSetGroundSpeed(character, 0);
+}
+
+void feed_random_input(Controller& controller, std::mt19937& rng) {
+    if(!controller.hold_frames) {
+        controller.direction = SDint(rng() % 3) - 1;
+        controller.jumping = (rng() % 8) == 0;
+        controller.hold_frames = 1 + rng() % 120;
+    }
+
+    --controller.hold_frames;
+
+    if(controller.direction < 0) {
+        sdCharacterLeftPressed(controller.character);
+    } else if(controller.direction > 0) {
+        sdCharacterRightPressed(controller.character);
+    }
+
+    if(controller.jumping) {
+        sdCharacterJumpPressed(controller.character);
+    }
+}
+
+void feed_scripted_input(Controller& controller, SDuint index, SDuint64 step) {
+    //Run back and forth in 10 second legs, with a short jump every two seconds
+    SDuint64 leg = (step + index * 37) / 600;
+    if(leg % 2) {
+        sdCharacterLeftPressed(controller.character);
+    } else {
+        sdCharacterRightPressed(controller.character);
+    }
+
+    if(((step + index * 11) % 120) < 10) {
+        sdCharacterJumpPressed(controller.character);
+    }
+}
+
+/*
+ * Checks the state of every character after a step. Anything that has gone NaN (or infinite),
+ * or has ended up beneath the terrain surface, is counted and put back on the
+ * terrain so that the soak can continue.
+ */
+void check_characters(const std::vector<Controller>& controllers, const Terrain& terrain, Stats& stats) {
+    for(const Controller& controller: controllers) {
+        SDfloat x, y;
+        sdObjectGetPosition(controller.character, &x, &y);
+
+        //Infinities are counted along with NaNs, either one poisons the character
+        bool is_nan = !std::isfinite(x) || !std::isfinite(y) ||
+            !std::isfinite(sdObjectGetSpeedX(controller.character)) ||
+            !std::isfinite(sdObjectGetSpeedY(controller.character));
+
+        if(is_nan) {
+            ++stats.nan_incidents;
+            place_on_terrain(controller.character, 0, terrain);
+            continue;
+        }
+
+        if(x < terrain.left || x > terrain.right() || y < terrain.height_at(x) - TUNNEL_TOLERANCE) {
+            ++stats.tunnel_incidents;
+            SDfloat clamped = std::min(std::max(x, terrain.left + 1.0f), terrain.right() - 1.0f);
+            place_on_terrain(controller.character, clamped, terrain);
+        }
+    }
+}
+
+long peak_rss_kb() {
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+    return usage.ru_maxrss; //Kilobytes on Linux
+}
+
+void report(const char* label, SDuint world, SDuint64 steps, const Stats& stats) {
+    double steps_per_second = (stats.total_seconds > 0) ? steps / stats.total_seconds : 0;
+
+    std::printf(
+        "[%s] steps=%llu steps/sec=%.1f p50=%.1fus p99=%.1fus peak_rss=%ldKB nan=%llu tunnelled=%llu\n",
+        label,
+        (unsigned long long) steps,
+        steps_per_second,
+        stats.step_latencies.percentile(0.50),
+        stats.step_latencies.percentile(0.99),
+        peak_rss_kb(),
+        (unsigned long long) stats.nan_incidents,
+        (unsigned long long) stats.tunnel_incidents
+    );
+
+    //How many collision tries each object update needed, the last bucket never settled
+    SDuint64 tries[16];
+    SDuint buckets = sdWorldGetCollisionTriesHistogram(world, tries, 16);
+
+    std::printf("[%s] tries", label);
+    for(SDuint i = 0; i < buckets; ++i) {
+        if(i + 1 == buckets) {
+            std::printf(" unsettled:%llu", (unsigned long long) tries[i]);
+        } else {
+            std::printf(" %u:%llu", i + 1, (unsigned long long) tries[i]);
+        }
+    }
+    std::printf("\n");
+    std::fflush(stdout);
+}
+
+/*
+ * Drops the boxes in columns of BOX_STACK_HEIGHT, with a small gap between each box
+ * so they all have to fall and land, then steps until everything is asleep.
+ */
+int run_box_stack(const Options& options) {
+    SDuint world = sdWorldCreate();
+    sdWorldEnableSleeping(world);
+
+    SDuint columns = (options.box_stack + BOX_STACK_HEIGHT - 1) / BOX_STACK_HEIGHT;
+    SDfloat half_width = columns * BOX_SIZE * 2.0f;
+
+    SDVec2 floor[4];
+    kmVec2Fill(&floor[0], -half_width, -1.0f);
+    kmVec2Fill(&floor[1], half_width, -1.0f);
+    kmVec2Fill(&floor[2], half_width, 0.0f);
+    kmVec2Fill(&floor[3], -half_width, 0.0f);
+    sdWorldAddBox(world, floor);
+
+    std::vector<SDuint> boxes(options.box_stack);
+    for(SDuint i = 0; i < boxes.size(); ++i) {
+        SDuint column = i / BOX_STACK_HEIGHT;
+        SDuint row = i % BOX_STACK_HEIGHT;
+
+        boxes[i] = sdBoxCreate(world, BOX_SIZE, BOX_SIZE);
+        sdObjectSetPosition(
+            boxes[i],
+            -half_width + BOX_SIZE * (1.0f + column * 2.0f),
+            BOX_SIZE * (0.5f + row * 1.1f)
+        );
+        sdBoxSetGravityEnabled(boxes[i], true);
+    }
+
+    std::printf(
+        "Settling %u boxes in %u columns for up to %llu steps\n",
+        options.box_stack, columns, (unsigned long long) options.steps
+    );
+
+    Stats stats;
+    typedef std::chrono::steady_clock Clock;
+
+    SDuint64 step = 0;
+    SDuint awake = boxes.size();
+    while(step < options.steps && awake) {
+        Clock::time_point start = Clock::now();
+        sdWorldStep(world, FRAME_TIME);
+        Clock::time_point end = Clock::now();
+
+        double elapsed = std::chrono::duration<double>(end - start).count();
+        stats.total_seconds += elapsed;
+        stats.step_latencies.add(elapsed * 1000000.0);
+        ++step;
+
+        awake = 0;
+        for(SDuint box: boxes) {
+            SDfloat y = sdObjectGetPositionY(box);
+            if(!std::isfinite(y)) {
+                ++stats.nan_incidents;
+            } else if(y < 0) {
+                ++stats.tunnel_incidents; //Fell through the floor
+            }
+
+            if(!sdObjectIsSleeping(box)) {
+                ++awake;
+            }
+        }
+
+        if(options.report_every && (step % options.report_every) == 0) {
+            report("progress", world, step, stats);
+        }
+    }
+
+    report("final", world, step, stats);
+    std::printf("%s after %llu steps, %u boxes still awake\n",
+        (awake) ? "Not settled" : "Settled", (unsigned long long) step, awake
+    );
+
+    sdWorldDestroy(world);
+
+    return (stats.nan_incidents || stats.tunnel_incidents || awake) ? 2 : 0;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if(!parse_options(argc, argv, options)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if(options.box_stack) {
+        return run_box_stack(options);
+    }
+
+    std::mt19937 rng(options.seed);
+
+    sdCharacterOverrideSetting("VERTICAL_SENSOR_EXTENSION_LENGTH", SENSOR_EXTENSION);
+
+    SDuint world = sdWorldCreate();
+    Terrain terrain = build_terrain(world, options.terrain_segments, rng);
+
+    std::uniform_real_distribution<SDfloat> spawn(terrain.left + 1.0f, terrain.right() - 1.0f);
+
+    std::vector<Controller> controllers(options.characters);
+    for(Controller& controller: controllers) {
+        controller.character = sdCharacterCreate(world);
+        place_on_terrain(controller.character, spawn(rng), terrain);
+    }
+
+    std::printf(
+        "Simulating %u characters over %u terrain segments for %llu steps (%s input)\n",
+        options.characters, options.terrain_segments, (unsigned long long) options.steps,
+        (options.input_mode == INPUT_MODE_RANDOM) ? "random" : "scripted"
+    );
+
+    Stats stats;
+
+    typedef std::chrono::steady_clock Clock;
+
+    for(SDuint64 step = 0; step < options.steps; ++step) {
+        for(SDuint i = 0; i < controllers.size(); ++i) {
+            if(options.input_mode == INPUT_MODE_RANDOM) {
+                feed_random_input(controllers[i], rng);
+            } else {
+                feed_scripted_input(controllers[i], i, step);
+            }
+        }
+
+        Clock::time_point start = Clock::now();
+        sdWorldStep(world, FRAME_TIME);
+        Clock::time_point end = Clock::now();
+
+        double elapsed = std::chrono::duration<double>(end - start).count();
+        stats.total_seconds += elapsed;
+        stats.step_latencies.add(elapsed * 1000000.0);
+
+        check_characters(controllers, terrain, stats);
+
+        if(options.report_every && ((step + 1) % options.report_every) == 0) {
+            report("progress", world, step + 1, stats);
+        }
+    }
+
+    report("final", world, options.steps, stats);
+
+    sdWorldDestroy(world);
+
+    return (stats.nan_incidents || stats.tunnel_incidents) ? 2 : 0;
+}
@@ -1,9 +1,27 @@
+#include <stdexcept>
 
 #include "box_object.h"
 #include "collision/box.h"
 
 BoxObject::BoxObject(World *world, float width, float height):
-    Object(world) {
+    RigidObject(world),
+    width_(width),
+    height_(height) {
 
     set_geom(CollisionPrimitive::ptr(new Box(this, width, height)));
 }
+
+BoxObject* BoxObject::get(SDuint object_id) {
+    BoxObject* box = dynamic_cast<BoxObject*>(Object::get(object_id));
+    if(!box) {
+        throw std::logic_error("Object is not a box");
+    }
+    return box;
+}
+
+Object::ptr BoxObject::clone(World* world) const {
+    BoxObject* copy = new BoxObject(*this);
+    copy->move_to_clone(world);
+    copy->set_geom(copy->clone_shape<Box>(geom()));
+    return Object::ptr(copy);
+}
@@ -1,13 +1,24 @@
 #ifndef OBJECT_BOX_H
 #define OBJECT_BOX_H
 
-#include "object.h"
+#include <cmath>
 
-class BoxObject : public Object {
+#include "rigid_object.h"
+
+class BoxObject : public RigidObject {
 public:
     BoxObject(World* world, float width, float height);
 
+    static BoxObject* get(SDuint object_id);
+    Object::ptr clone(World* world) const;
+
+    float sweep_extent(const kmVec2& direction) const {
+        return (std::fabs(direction.x) * width_ + std::fabs(direction.y) * height_) * 0.5f;
+    }
 
+private:
+    float width_;
+    float height_;
 };
 
 #endif // BOX_H
@@ -26,6 +26,24 @@ void Character::override_setting(const std::string &setting, float value) {
 
 const float WORLD_SCALE = 1.0f / 40.0f;
 
+const CharacterProfile& profile_preset(SDProfilePreset preset) {
+    static const CharacterProfile PRESETS[] = {
+        SONIC_PROFILE,
+        TAILS_PROFILE,
+        KNUCKLES_PROFILE,
+        UNDERWATER_PROFILE,
+        SUPER_PROFILE
+    };
+
+    //This comes straight from the C API, so it could be anything
+    if(uint32_t(preset) > uint32_t(SD_PROFILE_SUPER)) {
+        L_WARN("Invalid profile preset, using Sonic's");
+        return PRESETS[SD_PROFILE_SONIC];
+    }
+
+    return PRESETS[preset];
+}
+
 Character::Character(World* world, SDfloat width, SDfloat height):
     Object(world),
     original_height_(height),
@@ -36,20 +54,26 @@ Character::Character(World* world, SDfloat width, SDfloat height):
     enable_skill(SD_SKILL_ROLL);
     enable_skill(SD_SKILL_SPINDASH);
 
+    const float extension = Character::setting("VERTICAL_SENSOR_EXTENSION_LENGTH");
+
     for(int i = 0; i < QUADRANT_MAX; ++i) {
         auto base_standing = std::make_shared<RayBox>(
             this,
             width,
-            height + (Character::setting("VERTICAL_SENSOR_EXTENSION_LENGTH") * 2)
+            height + (extension * 2)
 
         );
 
         auto base_crouching = std::make_shared<RayBox>(
             this,
             (width * 0.75),
-            (height * 0.75) + (Character::setting("VERTICAL_SENSOR_EXTENSION_LENGTH") * 2)
+            (height * 0.75) + (extension * 2)
         );
 
+        //Other characters' sensors hit our actual body, not the reach of our sensors
+        base_standing->set_body_size(width, height);
+        base_crouching->set_body_size(width * 0.75, height * 0.75);
+
         //TODO: Transform all the rays...
 
         kmMat3 rotation;
@@ -78,7 +102,12 @@ Character::Character(World* world, SDfloat width, SDfloat height):
 ///Override from Object to prevent rotating the geom
 void Character::set_rotation(kmScalar angle) {
     //angle = (angle < 0) ? 360.0 + angle : angle;
-    rotation_ = angle;
+    set_ground_angle(SurfaceAngle::from_degrees(angle));
+}
+
+void Character::set_ground_angle(const SurfaceAngle& angle) {
+    rotation_ = angle.degrees;
+    ground_angle_ = angle;
 }
 
 void Character::set_quadrant(Quadrant quadrant) {
@@ -158,53 +187,13 @@ std::pair<Collision, bool> Character::find_collision_with_ray(const std::vector<
 }
 
 
-std::pair<Collision, bool> Character::find_nearest_collision_with_ray(
-	const std::vector<Collision>& collisions,
-	char ray,
-    float bounds,
-    float& closest_distance) {
-
+SensorHit Character::nearest_hit(Sensor sensor, float bounds, float& closest_distance) {
     const float FLOAT_MAX = std::numeric_limits<float>::max();
 
-	bool found = false;
-    kmScalar closest = FLOAT_MAX;
-	Collision final;
-	
-	for(Collision c: collisions) {						
-		if(c.a_ray == ray) {			
-			RayBox* ray_box = dynamic_cast<RayBox*>(c.object_a);
-			
-			kmScalar distance = kmVec2DistanceBetween(&c.point, &ray_box->ray(ray).start);		
-			
-			if(distance < closest) {
-				final = c;
-				closest = distance;
-				found = true;
-			}
-		}
-	}
-	
-
-    closest_distance = closest;
-    if(closest_distance > bounds) {
-        closest_distance = FLOAT_MAX;
-    }
-
-	return std::make_pair(final, found);
-}
-
-float calc_angle_from_up(const kmVec2& vec) {
-	kmVec2 up, n;
-	kmVec2Fill(&up, 0.0, 1.0);
-	kmVec2Normalize(&n, &vec);
-
-    float angle = kmRadiansToDegrees(atan2(vec.x * up.y - vec.y * up.x, vec.x * up.x + vec.y * up.y));
+    const SensorHit& hit = dynamic_cast<RayBox&>(geom()).nearest_hit(sensor);
 
-    if(angle < 0) {
-        angle = 360 + angle;
-    }
-
-    return angle;
+    closest_distance = (hit.found && hit.distance <= bounds) ? hit.distance : FLOAT_MAX;
+    return hit;
 }
 
 void Character::pre_prepare(float dt) {
@@ -215,56 +204,56 @@ void Character::pre_prepare(float dt) {
     if(x_axis_state_ == AXIS_STATE_NEGATIVE) {
         if(is_grounded()) {
             if(gsp_ > 0) {
-                gsp_ -= deceleration_rate_ * dt;
-            } else  if(gsp_ > -top_speed_) {
-                gsp_ -= acceleration_rate_ * dt;
-                if(fabs(gsp_) > top_speed_) {
-                    gsp_ = -top_speed_;
+                gsp_ -= profile_.deceleration * dt;
+            } else  if(gsp_ > -profile_.top_speed) {
+                gsp_ -= profile_.acceleration * dt;
+                if(fabs(gsp_) > profile_.top_speed) {
+                    gsp_ = -profile_.top_speed;
                 }
             }
         } else {
-            if(velocity_.x > -top_speed_) {
-                velocity_.x -= (acceleration_rate_ * 2.0 * dt);
-                if(fabs(velocity_.x) > top_speed_) {
-                    velocity_.x = -top_speed_;
+            if(velocity_.x > -profile_.top_speed) {
+                velocity_.x -= (profile_.acceleration * 2.0 * dt);
+                if(fabs(velocity_.x) > profile_.top_speed) {
+                    velocity_.x = -profile_.top_speed;
                 }
             }
         }
     } else if(x_axis_state_ == AXIS_STATE_POSITIVE) {
         if(is_grounded()) {
             if(gsp_ < 0) {
-                gsp_ += deceleration_rate_ * dt;
-            } else if(gsp_ < top_speed_) {
-                gsp_ += acceleration_rate_ * dt;
-                if(fabs(gsp_) > top_speed_) {
-                    gsp_ = top_speed_;
+                gsp_ += profile_.deceleration * dt;
+            } else if(gsp_ < profile_.top_speed) {
+                gsp_ += profile_.acceleration * dt;
+                if(fabs(gsp_) > profile_.top_speed) {
+                    gsp_ = profile_.top_speed;
                 }
             }
         } else {
-            if(velocity_.x < top_speed_) {
-                velocity_.x += (acceleration_rate_ * 2.0 * dt);
-                if(fabs(velocity_.x) > top_speed_) {
-                    velocity_.x = top_speed_;
+            if(velocity_.x < profile_.top_speed) {
+                velocity_.x += (profile_.acceleration * 2.0 * dt);
+                if(fabs(velocity_.x) > profile_.top_speed) {
+                    velocity_.x = profile_.top_speed;
                 }
             }
         }
     } else if(x_axis_state_ == AXIS_STATE_NEUTRAL){
         if(is_grounded()) {
-            gsp_ -= std::min<float>(fabs(gsp_), friction_rate_ * dt) * sgn(gsp_);
-            gsp_ += slope_rate_ * sin(kmDegreesToRadians(rotation_)) * dt;
+            gsp_ -= std::min<float>(fabs(gsp_), profile_.friction * dt) * sgn(gsp_);
+            gsp_ += profile_.slope * ground_angle_.sin * dt;
         }
     }
 
     if(is_grounded()) {
-        velocity_.x = gsp_ * cos(kmDegreesToRadians(rotation_));
-        velocity_.y = gsp_ * -sin(kmDegreesToRadians(rotation_));
+        velocity_.x = gsp_ * ground_angle_.cos;
+        velocity_.y = gsp_ * -ground_angle_.sin;
     }
 
     //Apply gravity if the character is attached to a world
     if(!is_grounded()) {
         //Air drag
-        if(velocity_.y > 0 && velocity_.y < air_drag_max_y_ && fabs(velocity_.x) > air_drag_min_x_) {
-            velocity_.x *= (air_drag_rate_ * dt);
+        if(velocity_.y > 0 && velocity_.y < profile_.air_drag_max_y_speed && fabs(velocity_.x) > profile_.air_drag_min_x_speed) {
+            velocity_.x *= (profile_.air_drag_rate * dt);
         }
 
         if(world()) {
@@ -277,28 +266,38 @@ void Character::pre_prepare(float dt) {
 
     if(action_button_state_) {
         if(!last_action_button_state_ && is_grounded()) {
-            velocity_.y = jump_rate_;
+            velocity_.y = profile_.initial_jump;
             animation_state_ = ANIMATION_STATE_JUMPING;
             ground_state_ = GROUND_STATE_IN_THE_AIR;
         }
     } else {
-        if(last_action_button_state_ && velocity_.y > jump_cut_off_ && !is_grounded()) {
-            velocity_.y = jump_cut_off_;
+        if(last_action_button_state_ && velocity_.y > profile_.jump_cut_off && !is_grounded()) {
+            velocity_.y = profile_.jump_cut_off;
         }
     }
 
-    if(fabs(velocity_.y) > top_y_speed_) {
-        velocity_.y = top_y_speed_ * sgn(velocity_.y);
+    if(fabs(velocity_.y) > profile_.top_y_speed) {
+        velocity_.y = profile_.top_y_speed * sgn(velocity_.y);
     }
 }
 
 bool Character::respond_to(const std::vector<Collision>& collisions) {
+    /*
+     * The narrowphase has already kept the nearest hit of each sensor, the
+     * world passes no contacts for us. Anything that is passed in (e.g. by
+     * the tests) is added on top. The hits are copied out as responding can
+     * switch to a different shape.
+     */
+    RayBox& ray_box = dynamic_cast<RayBox&>(geom());
+    ray_box.record_hits(collisions);
+
     float a_dist, b_dist, l_dist, r_dist, e_dist;
-    std::pair<Collision, bool> a = find_nearest_collision_with_ray(collisions, 'A', height_ / 2, a_dist);
-    std::pair<Collision, bool> b = find_nearest_collision_with_ray(collisions, 'B', height_ / 2, b_dist);
-    std::pair<Collision, bool> l = find_nearest_collision_with_ray(collisions, 'L', width_ /2, l_dist);
-    std::pair<Collision, bool> r = find_nearest_collision_with_ray(collisions, 'R', width_ / 2, r_dist);
-    std::pair<Collision, bool> e = find_nearest_collision_with_ray(collisions, 'E', height_ / 2, e_dist);
+    SensorHit a = nearest_hit(SENSOR_A, height_ / 2, a_dist);
+    SensorHit b = nearest_hit(SENSOR_B, height_ / 2, b_dist);
+    SensorHit l = nearest_hit(SENSOR_L, width_ /2, l_dist);
+    SensorHit r = nearest_hit(SENSOR_R, width_ / 2, r_dist);
+    SensorHit e = nearest_hit(SENSOR_E, height_ / 2, e_dist);
+    ray_box.clear_hits();
 
 	//Store the original position, we need this to work out
 	//if anything changed
@@ -311,11 +310,11 @@ bool Character::respond_to(const std::vector<Collision>& collisions) {
 
     bool a_collided_within_height = a_dist < FLOAT_MAX;
     bool b_collided_within_height = b_dist < FLOAT_MAX;
-    bool a_collided = a.second;
-    bool b_collided = b.second;
-    bool e_collided = e.second;
-    bool l_collided = l.second;
-    bool r_collided = r.second;
+    bool a_collided = a.found;
+    bool b_collided = b.found;
+    bool e_collided = e.found;
+    bool l_collided = l.found;
+    bool r_collided = r.found;
 
     bool a_b_respond = false;
 
@@ -369,57 +368,59 @@ bool Character::respond_to(const std::vector<Collision>& collisions) {
     if(a_b_respond) {
         kmVec2 new_location;
         kmVec2Assign(&new_location, &original_position);
-        float new_angle;
-        if(a_dist <= b_dist) {
-            float new_y = a.first.point.y + (height_ / 2.0);
+        SurfaceAngle new_angle;
+        //Both can be out of reach (grounded characters follow hits past their feet), only use one that hit something
+        if(a.found && (a_dist <= b_dist || !b.found)) {
+            float new_y = a.point.y + (height_ / 2.0);
             if(is_grounded()) {
                 new_location.y = new_y;
             } else if(new_location.y < new_y) {
                 //If we are in the air, only set the new height if we are less than it
                 new_location.y = new_y;
             }
-            new_angle = calc_angle_from_up(a.first.b_normal);
+            new_angle = a.angle;
         } else {
-            float new_y = b.first.point.y + (height_ / 2.0);
+            float new_y = b.point.y + (height_ / 2.0);
             if(is_grounded()) {
                 new_location.y = new_y;
             } else if(new_location.y < new_y) {
                 new_location.y = new_y;
             }
-            new_angle = calc_angle_from_up(b.first.b_normal);
+            new_angle = b.angle;
         }
 
         //Handle quadrant switching
-        if(new_angle < 45 || new_angle > 315) {
+        float degrees = new_angle.degrees;
+        if(degrees < 45 || degrees > 315) {
             set_quadrant(QUADRANT_FLOOR);
-        } else if(new_angle > 45 && new_angle < 135) {
+        } else if(degrees > 45 && degrees < 135) {
             set_quadrant(QUADRANT_LEFT_WALL);
-        } else if(new_angle > 135 && new_angle < 225) {
+        } else if(degrees > 135 && degrees < 225) {
             set_quadrant(QUADRANT_CEILING);
-        } else if(new_angle > 225 && new_angle < 315) {
+        } else if(degrees > 225 && degrees < 315) {
             set_quadrant(QUADRANT_RIGHT_WALL);
         }
 
 
         set_position(new_location.x, new_location.y);
-        set_rotation(new_angle);
+        set_ground_angle(new_angle);
 
         if(!was_grounded && is_grounded()) {
             //We just hit the ground
-            float test_angle = (new_angle > 90) ? fabs(new_angle - 360.0) : new_angle;
+            float test_angle = (degrees > 90) ? fabs(degrees - 360.0) : degrees;
             if(test_angle < 22.5) {
                 gsp_ = velocity().x;
             } else if(test_angle < 45.0) {
                 if(velocity().x > fabs(velocity().y)) {
                     gsp_ = velocity().x;
                 } else {
-                    gsp_ = velocity().y * 0.5 * -sgn(cos(kmDegreesToRadians(new_angle)));
+                    gsp_ = velocity().y * 0.5 * -sgn(new_angle.cos);
                 }
             } else {
                 if(velocity().x > fabs(velocity().y)) {
                     gsp_ = velocity().x;
                 } else {
-                    gsp_ = velocity().y * -sgn(cos(kmDegreesToRadians(new_angle)));
+                    gsp_ = velocity().y * -sgn(new_angle.cos);
                 }
             }
         }
@@ -453,6 +454,43 @@ bool Character::respond_to(const std::vector<Collision>& collisions) {
     return !kmVec2AreEqual(&original_position, &position());
 }
 
+void Character::apply_input(SDuint buttons) {
+    //Opposite directions held together cancel each other out
+    bool left = buttons & SD_INPUT_LEFT;
+    bool right = buttons & SD_INPUT_RIGHT;
+    bool up = buttons & SD_INPUT_UP;
+    bool down = buttons & SD_INPUT_DOWN;
+
+    if(left != right) {
+        (left) ? move_left() : move_right();
+    }
+
+    if(up != down) {
+        (up) ? move_up() : move_down();
+    }
+
+    if(buttons & SD_INPUT_JUMP) {
+        jump();
+    }
+}
+
+uint32_t Character::sweep_origins(kmVec2* origins) const {
+    const RayBox& ray_box = dynamic_cast<const RayBox&>(geom());
+
+    origins[0] = position();
+    origins[1] = ray_box.ray('A').start;
+    origins[2] = ray_box.ray('B').start;
+    return 3;
+}
+
+bool Character::can_sleep() const {
+    //Only park characters that are standing still on the ground with nothing pressed
+    return is_grounded() && gsp_ == 0.0 &&
+        last_x_axis_state_ == AXIS_STATE_NEUTRAL &&
+        last_y_axis_state_ == AXIS_STATE_NEUTRAL &&
+        !last_action_button_state_;
+}
+
 void Character::update_finished(float dt) {
     //After collisions have been processed
 
@@ -525,3 +563,22 @@ Character* Character::get(SDuint object_id) {
     return c;
 }
 
+Object::ptr Character::clone(World* world) const {
+    Character* copy = new Character(*this);
+    copy->move_to_clone(world);
+
+    //Every shape the character can switch to needs copying, then the copy of the current one is used
+    for(uint32_t i = 0; i < QUADRANT_MAX; ++i) {
+        copy->standing_shape_[i] = copy->clone_shape<RayBox>(*standing_shape_[i]);
+        copy->crouching_shape_[i] = copy->clone_shape<RayBox>(*crouching_shape_[i]);
+
+        if(&geom() == standing_shape_[i].get()) {
+            copy->set_geom(copy->standing_shape_[i]);
+        } else if(&geom() == crouching_shape_[i].get()) {
+            copy->set_geom(copy->crouching_shape_[i]);
+        }
+    }
+
+    return Object::ptr(copy);
+}
+
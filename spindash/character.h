@@ -2,6 +2,8 @@
 #define CHARACTER_H
 
 #include <map>
+#include <algorithm>
+#include <cmath>
 
 #include "spindash.h"
 #include "object.h"
@@ -42,17 +44,86 @@ enum WallState {
     WALL_STATE_COLLIDED_RIGHT
 };
 
-const float DEFAULT_ACCELERATION_IN_MPS = ((0.046875 / 40.0) * 60.0);
-const float DEFAULT_DECELERATION_IN_MPS = ((0.5 / 40.0) * 60.0);
-const float DEFAULT_FRICTION_IN_MPS = DEFAULT_ACCELERATION_IN_MPS;
-const float DEFAULT_TOP_SPEED_IN_M = ((6.0 / 40.0));
-const float DEFAULT_TOP_Y_SPEED_IN_M = ((16.0 / 40.0));
-const float DEFAULT_SLOPE_IN_MPS = ((0.125 / 40.0) * 60.0);
-const float DEFAULT_INITIAL_JUMP_IN_M = ((6.5 / 40.0));
-const float DEFAULT_JUMP_CUT_OFF_IN_M = ((4.0 / 40.0));
-const float DEFAULT_AIR_DRAG_RATE = 0.96875 * 60.0; //This is the fraction left after a second
-const float DEFAULT_AIR_DRAG_MIN_X_SPEED = ((0.125 / 40.0));
-const float DEFAULT_AIR_DRAG_MAX_Y_SPEED = DEFAULT_JUMP_CUT_OFF_IN_M;
+constexpr float DEFAULT_ACCELERATION_IN_MPS = ((0.046875 / 40.0) * 60.0);
+constexpr float DEFAULT_DECELERATION_IN_MPS = ((0.5 / 40.0) * 60.0);
+constexpr float DEFAULT_FRICTION_IN_MPS = DEFAULT_ACCELERATION_IN_MPS;
+constexpr float DEFAULT_TOP_SPEED_IN_M = ((6.0 / 40.0));
+constexpr float DEFAULT_TOP_Y_SPEED_IN_M = ((16.0 / 40.0));
+constexpr float DEFAULT_SLOPE_IN_MPS = ((0.125 / 40.0) * 60.0);
+constexpr float DEFAULT_INITIAL_JUMP_IN_M = ((6.5 / 40.0));
+constexpr float DEFAULT_JUMP_CUT_OFF_IN_M = ((4.0 / 40.0));
+constexpr float DEFAULT_AIR_DRAG_RATE = 0.96875 * 60.0; //This is the fraction left after a second
+constexpr float DEFAULT_AIR_DRAG_MIN_X_SPEED = ((0.125 / 40.0));
+constexpr float DEFAULT_AIR_DRAG_MAX_Y_SPEED = DEFAULT_JUMP_CUT_OFF_IN_M;
+typedef SDCharacterProfile CharacterProfile;
+
+constexpr CharacterProfile SONIC_PROFILE = {
+    DEFAULT_ACCELERATION_IN_MPS,
+    DEFAULT_DECELERATION_IN_MPS,
+    DEFAULT_FRICTION_IN_MPS,
+    DEFAULT_TOP_SPEED_IN_M,
+    DEFAULT_TOP_Y_SPEED_IN_M,
+    DEFAULT_SLOPE_IN_MPS,
+    DEFAULT_INITIAL_JUMP_IN_M,
+    DEFAULT_JUMP_CUT_OFF_IN_M,
+    DEFAULT_AIR_DRAG_RATE,
+    DEFAULT_AIR_DRAG_MIN_X_SPEED,
+    DEFAULT_AIR_DRAG_MAX_Y_SPEED
+};
+
+//Tails moves exactly like Sonic on the ground and in the air
+constexpr CharacterProfile TAILS_PROFILE = SONIC_PROFILE;
+
+//Knuckles jumps a little lower
+constexpr CharacterProfile KNUCKLES_PROFILE = {
+    DEFAULT_ACCELERATION_IN_MPS,
+    DEFAULT_DECELERATION_IN_MPS,
+    DEFAULT_FRICTION_IN_MPS,
+    DEFAULT_TOP_SPEED_IN_M,
+    DEFAULT_TOP_Y_SPEED_IN_M,
+    DEFAULT_SLOPE_IN_MPS,
+    (6.0 / 40.0),
+    DEFAULT_JUMP_CUT_OFF_IN_M,
+    DEFAULT_AIR_DRAG_RATE,
+    DEFAULT_AIR_DRAG_MIN_X_SPEED,
+    DEFAULT_AIR_DRAG_MAX_Y_SPEED
+};
+
+/*
+ * Underwater the acceleration, deceleration, friction, top speed and jump
+ * cut off are halved, and the jump drops from 6.5 to 3.5. The slope factor,
+ * top Y speed and air drag stay the same.
+ */
+constexpr CharacterProfile UNDERWATER_PROFILE = {
+    ((0.0234375 / 40.0) * 60.0),
+    ((0.25 / 40.0) * 60.0),
+    ((0.0234375 / 40.0) * 60.0),
+    (3.0 / 40.0),
+    DEFAULT_TOP_Y_SPEED_IN_M,
+    DEFAULT_SLOPE_IN_MPS,
+    (3.5 / 40.0),
+    (2.0 / 40.0),
+    DEFAULT_AIR_DRAG_RATE,
+    DEFAULT_AIR_DRAG_MIN_X_SPEED,
+    DEFAULT_AIR_DRAG_MAX_Y_SPEED
+};
+
+constexpr CharacterProfile SUPER_PROFILE = {
+    ((0.1875 / 40.0) * 60.0),
+    ((1.0 / 40.0) * 60.0),
+    DEFAULT_FRICTION_IN_MPS,
+    (10.0 / 40.0),
+    DEFAULT_TOP_Y_SPEED_IN_M,
+    DEFAULT_SLOPE_IN_MPS,
+    (8.0 / 40.0),
+    DEFAULT_JUMP_CUT_OFF_IN_M,
+    DEFAULT_AIR_DRAG_RATE,
+    DEFAULT_AIR_DRAG_MIN_X_SPEED,
+    DEFAULT_AIR_DRAG_MAX_Y_SPEED
+};
+
+const CharacterProfile& profile_preset(SDProfilePreset preset);
+
 const float ANIMATION_RUNNING_MIN_X_SPEED = (6.0 / 40.0);
 const float ANIMATION_DASHING_MIN_X_SPEED = (10.0 / 40.0);
 const float MIN_ROLLING_SPEED = (1.03125 / 40.0);
@@ -60,6 +131,7 @@ const float MIN_ROLLING_SPEED = (1.03125 / 40.0);
 class Character : public Object {
 public:
     static Character* get(SDuint object_id);
+    Object::ptr clone(World* world) const;
 
     static float setting(const std::string& setting);
     static void override_setting(const std::string& setting, float value);
@@ -90,27 +162,39 @@ public:
 
     void move_left() {
         x_axis_state_ = AXIS_STATE_NEGATIVE;
+        wake();
 	}
 
     void move_right() {
         x_axis_state_ = AXIS_STATE_POSITIVE;
+        wake();
 	}
 
     void move_up() {
         y_axis_state_ = AXIS_STATE_POSITIVE;
+        wake();
     }
 
     void move_down() {
         y_axis_state_ = AXIS_STATE_NEGATIVE;
+        wake();
     }
 
     void jump() {
         action_button_state_ = true;
+        wake();
     }
 
+    void apply_input(SDuint buttons);
+
     bool is_grounded() { return ground_state_ != GROUND_STATE_IN_THE_AIR; }
 
     bool respond_to(const std::vector<Collision>& collisions);
+    float sweep_extent(const kmVec2& direction) const {
+        return (std::fabs(direction.x) * width_ + std::fabs(direction.y) * height_) * 0.5f;
+    }
+    uint32_t sweep_origins(kmVec2* origins) const; //The centre, and the feet so ledges aren't missed
+    bool can_sleep() const;
     
     SDfloat width() const { return width_; }
     
@@ -133,6 +217,9 @@ public:
     SDAnimationState animation_state() const { return animation_state_; }
 
     SDDirection facing() const { return facing_; }
+
+    void set_profile(const CharacterProfile& profile) { profile_ = profile; }
+    const CharacterProfile& profile() const { return profile_; }
 private:
 
     // ============== NEW STUFF ================
@@ -143,6 +230,15 @@ private:
     Quadrant quadrant_ = QUADRANT_FLOOR;
     GroundState ground_state_ = GROUND_STATE_IN_THE_AIR;
     WallState wall_state_ = WALL_STATE_NO_COLLISION;
+
+    /*
+     * rotation_ along with its sine and cosine, which moving along the ground
+     * needs every step. It's copied straight from the surface that was landed
+     * on, where they were worked out when the geometry was built.
+     */
+    SurfaceAngle ground_angle_;
+    void set_ground_angle(const SurfaceAngle& angle);
+
     bool is_grounded() const { return ground_state_ != GROUND_STATE_IN_THE_AIR; }
 
     // =========================================
@@ -156,9 +252,7 @@ private:
 		if(horizontal_control_lock_ < 0.0) horizontal_control_lock_ = 0.0;
 	}
 
-    std::pair<Collision, bool> find_nearest_collision_with_ray(const std::vector<Collision>& collisions,
-        char ray, float bounds,
-        float& closest_distance);
+    SensorHit nearest_hit(Sensor sensor, float bounds, float& closest_distance);
 
     Collision find_nearest_collision(const std::vector<Collision>& collisions);
     std::pair<Collision, bool> find_collision_with_ray(const std::vector<Collision>& collisions, char ray);
@@ -192,17 +286,7 @@ private:
     void pre_prepare(float dt);
 
     bool was_grounded_= false;
-    float acceleration_rate_ = DEFAULT_ACCELERATION_IN_MPS;
-    float deceleration_rate_ = DEFAULT_DECELERATION_IN_MPS;
-    float friction_rate_ = DEFAULT_FRICTION_IN_MPS;
-    float top_speed_ = DEFAULT_TOP_SPEED_IN_M;
-    float top_y_speed_ = DEFAULT_TOP_Y_SPEED_IN_M;
-    float slope_rate_ = DEFAULT_SLOPE_IN_MPS;
-    float jump_rate_ = DEFAULT_INITIAL_JUMP_IN_M;
-    float jump_cut_off_ = DEFAULT_JUMP_CUT_OFF_IN_M;
-    float air_drag_rate_ = DEFAULT_AIR_DRAG_RATE;
-    float air_drag_min_x_ = DEFAULT_AIR_DRAG_MIN_X_SPEED;
-    float air_drag_max_y_ = DEFAULT_AIR_DRAG_MAX_Y_SPEED;
+    CharacterProfile profile_ = SONIC_PROFILE;
 };
 
 extern bool debug_break;
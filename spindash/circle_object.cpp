@@ -0,0 +1,26 @@
+#include <stdexcept>
+
+#include "circle_object.h"
+#include "collision/circle.h"
+
+CircleObject::CircleObject(World *world, float diameter):
+    RigidObject(world),
+    diameter_(diameter) {
+
+    set_geom(CollisionPrimitive::ptr(new Circle(this, diameter * 0.5f)));
+}
+
+CircleObject* CircleObject::get(SDuint object_id) {
+    CircleObject* circle = dynamic_cast<CircleObject*>(Object::get(object_id));
+    if(!circle) {
+        throw std::logic_error("Object is not a circle");
+    }
+    return circle;
+}
+
+Object::ptr CircleObject::clone(World* world) const {
+    CircleObject* copy = new CircleObject(*this);
+    copy->move_to_clone(world);
+    copy->set_geom(copy->clone_shape<Circle>(geom()));
+    return Object::ptr(copy);
+}
@@ -0,0 +1,19 @@
+#ifndef OBJECT_CIRCLE_H
+#define OBJECT_CIRCLE_H
+
+#include "rigid_object.h"
+
+class CircleObject : public RigidObject {
+public:
+    CircleObject(World* world, float diameter);
+
+    static CircleObject* get(SDuint object_id);
+    Object::ptr clone(World* world) const;
+
+    float sweep_extent(const kmVec2& direction) const { return diameter_ * 0.5f; }
+
+private:
+    float diameter_;
+};
+
+#endif // OBJECT_CIRCLE_H
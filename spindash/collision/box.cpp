@@ -17,12 +17,20 @@ Box::Box(Object* owner, float width, float height):
 }
 
 void Box::set_position(float x, float y) {
+    if(x == x_ && y == y_) {
+        return;
+    }
+
     x_ = x;
     y_ = y;
-    init();
+    points_dirty_ = true;
 }
 
 void Box::set_rotation(float angle) {
+    if(angle == degrees_) {
+        return;
+    }
+
     degrees_ = angle;
     init();
 }
@@ -31,27 +39,51 @@ void Box::init() {
     float hw = width_ * 0.5f;
     float hh = height_ * 0.5f;
 
-    points_[0].x = -hw;
-    points_[0].y = -hh;
+    local_points_[0].x = -hw;
+    local_points_[0].y = -hh;
     
-    points_[1].x = hw;
-    points_[1].y = -hh;
+    local_points_[1].x = hw;
+    local_points_[1].y = -hh;
 
-    points_[2].x = hw;
-    points_[2].y = hh;
+    local_points_[2].x = hw;
+    local_points_[2].y = hh;
     
-    points_[3].x = -hw;
-    points_[3].y = hh;
+    local_points_[3].x = -hw;
+    local_points_[3].y = hh;
     
     kmMat3 rotation;
     kmMat3RotationZ(&rotation, kmDegreesToRadians(degrees_));
     
-    kmVec2 translation;
-    kmVec2Fill(&translation, x_, y_);
-    
-    //Rotate the box to match the angle and add the position
+    //Rotate the box to match the angle, the position is added when the points are read
     for(uint32_t i = 0; i < 4; ++i) {
-        kmVec2Transform(&points_[i], &points_[i], &rotation);
-        kmVec2Add(&points_[i], &points_[i], &translation);
-    }        
+        kmVec2Transform(&local_points_[i], &local_points_[i], &rotation);
+    }
+
+    calculate_edge_normals(local_points_, 4, normals_);
+    calculate_edge_angles(normals_, 4, angles_);
+    points_dirty_ = true;
+}
+
+void Box::set_points(const kmVec2& v1, const kmVec2& v2, const kmVec2& v3, const kmVec2& v4) {
+    points_[0] = v1;
+    points_[1] = v2;
+    points_[2] = v3;
+    points_[3] = v4;
+    points_dirty_ = false;
+
+    calculate_edge_normals(points_, 4, normals_);
+    calculate_edge_angles(normals_, 4, angles_);
+}
+
+void Box::update_points() const {
+    if(!points_dirty_) {
+        return;
+    }
+
+    for(uint32_t i = 0; i < 4; ++i) {
+        points_[i].x = local_points_[i].x + x_;
+        points_[i].y = local_points_[i].y + y_;
+    }
+
+    points_dirty_ = false;
 }
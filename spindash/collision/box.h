@@ -8,16 +8,34 @@ class Box : public CollisionPrimitive {
 public:
     Box(Object* owner, float width, float height);
     
+    /*
+     * Static boxes are built with this and have their points written directly,
+     * they're never moved so the points are never rebuilt
+     */
     Box():
-        CollisionPrimitive(nullptr) {
+        CollisionPrimitive(nullptr),
+        x_(0.0f),
+        y_(0.0f),
+        width_(0.0f),
+        height_(0.0f),
+        degrees_(0.0f) {
         
     }
     
     void set_position(float x, float y);
     void set_rotation(float angle);
+    AABB bounds() const { return AABB::from_points(points(), 4); }
     
-    kmVec2& point(const int i) { return points_[i]; }
-    kmVec2* points() { return points_; }
+    kmVec2& point(const int i) { return points()[i]; }
+    kmVec2* points() { update_points(); return points_; }
+    const kmVec2* points() const { update_points(); return points_; }
+
+    ///For static boxes, sets the points directly
+    void set_points(const kmVec2& v1, const kmVec2& v2, const kmVec2& v3, const kmVec2& v4);
+
+    ///Outward normal of the edge from point(i) to point(i + 1), these don't depend on the position
+    const kmVec2* normals() const { return normals_; }
+    const SurfaceAngle* angles() const { return angles_; }
 
     void set_geometry_handle(SDGeometryHandle handle) { handle_ = handle; }
     SDGeometryHandle geometry_handle() const { return handle_; }
@@ -28,9 +46,19 @@ private:
     float height_;
     float degrees_;
     
-    kmVec2 points_[4];
-    
-    void init();    
+    /*
+     * The rotated corners are only recalculated when the rotation changes, and
+     * the translated ones only when something actually reads them, so boxes
+     * that move but are never queried cost nothing
+     */
+    kmVec2 local_points_[4];
+    kmVec2 normals_[4] = {};
+    SurfaceAngle angles_[4];
+    mutable kmVec2 points_[4];
+    mutable bool points_dirty_ = false;
+
+    void init();
+    void update_points() const;
 
     SDGeometryHandle handle_ = 0;
 };
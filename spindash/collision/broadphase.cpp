@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <cassert>
+
+#include "broadphase.h"
+
+void Broadphase::add(uint32_t index, const AABB& bounds) {
+    Proxy proxy;
+    proxy.index = index;
+    proxy.bounds = bounds;
+    proxies_.push_back(proxy);
+    sorted_ = false;
+}
+
+void Broadphase::sort() {
+    std::sort(proxies_.begin(), proxies_.end(), [](const Proxy& lhs, const Proxy& rhs) {
+        return lhs.bounds.min.x < rhs.bounds.min.x;
+    });
+
+    max_width_ = 0.0f;
+    for(const Proxy& proxy: proxies_) {
+        max_width_ = std::max(max_width_, proxy.bounds.max.x - proxy.bounds.min.x);
+    }
+
+    sorted_ = true;
+}
+
+void Broadphase::find_pairs(std::vector<BroadphasePair>& pairs) {
+    pairs.clear();
+    sort();
+
+    for(uint32_t i = 0; i < proxies_.size(); ++i) {
+        const Proxy& lhs = proxies_[i];
+
+        for(uint32_t j = i + 1; j < proxies_.size(); ++j) {
+            const Proxy& rhs = proxies_[j];
+            if(rhs.bounds.min.x > lhs.bounds.max.x) {
+                break; //Nothing further along can overlap
+            }
+
+            if(lhs.bounds.overlaps(rhs.bounds)) {
+                pairs.push_back(std::make_pair(
+                    std::min(lhs.index, rhs.index),
+                    std::max(lhs.index, rhs.index)
+                ));
+            }
+        }
+    }
+
+    std::sort(pairs.begin(), pairs.end());
+}
+
+void Broadphase::query(const AABB& area, std::vector<uint32_t>& indexes) const {
+    assert(sorted_);
+    indexes.clear();
+
+    //Nothing starting further back than the widest proxy can reach the area
+    auto it = std::lower_bound(proxies_.begin(), proxies_.end(), area.min.x - max_width_,
+        [](const Proxy& proxy, float x) { return proxy.bounds.min.x < x; }
+    );
+
+    for(; it != proxies_.end() && it->bounds.min.x <= area.max.x; ++it) {
+        if(it->bounds.overlaps(area)) {
+            indexes.push_back(it->index);
+        }
+    }
+
+    std::sort(indexes.begin(), indexes.end());
+}
@@ -0,0 +1,48 @@
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#include <vector>
+#include <utility>
+
+#include "collision_primitive.h"
+
+typedef std::pair<uint32_t, uint32_t> BroadphasePair;
+
+/**
+    A sort-and-sweep broadphase.
+
+    Proxies are added with an index (usually the position of the owning object
+    in the world) and their bounds. find_pairs then sorts the proxies along the
+    X axis and sweeps them, reporting every pair with overlapping bounds. Pairs
+    always have the lower index first and are returned in sorted order so that
+    anything iterating them is deterministic.
+
+    Once sorted (by sort or find_pairs) the proxies can also be queried for
+    everything overlapping an area, the indexes come back in ascending order.
+*/
+
+class Broadphase {
+public:
+    void clear() {
+        proxies_.clear();
+        sorted_ = false;
+    }
+
+    void add(uint32_t index, const AABB& bounds);
+
+    void sort();
+    void find_pairs(std::vector<BroadphasePair>& pairs);
+    void query(const AABB& area, std::vector<uint32_t>& indexes) const;
+
+private:
+    struct Proxy {
+        uint32_t index;
+        AABB bounds;
+    };
+
+    std::vector<Proxy> proxies_;
+    bool sorted_ = false;
+    float max_width_ = 0.0f; //Of any proxy, so a query knows how far back along X to start
+};
+
+#endif
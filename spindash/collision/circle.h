@@ -0,0 +1,33 @@
+#ifndef SD_CIRCLE_H
+#define SD_CIRCLE_H
+
+#include "collision_primitive.h"
+
+class Circle : public CollisionPrimitive {
+public:
+    Circle(Object* owner, float radius):
+        CollisionPrimitive(owner),
+        radius_(radius) {
+
+        kmVec2Fill(&center_, 0, 0);
+    }
+
+    void set_position(float x, float y) { kmVec2Fill(&center_, x, y); }
+    void set_rotation(float degrees) {} //Circles look the same whichever way they face
+
+    AABB bounds() const {
+        AABB result;
+        kmVec2Fill(&result.min, center_.x - radius_, center_.y - radius_);
+        kmVec2Fill(&result.max, center_.x + radius_, center_.y + radius_);
+        return result;
+    }
+
+    const kmVec2& center() const { return center_; }
+    float radius() const { return radius_; }
+
+private:
+    kmVec2 center_;
+    float radius_;
+};
+
+#endif // SD_CIRCLE_H
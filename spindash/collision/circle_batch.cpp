@@ -0,0 +1,53 @@
+#include <limits>
+
+#include "circle_batch.h"
+
+void CircleBatch::clear() {
+    indexes_.clear();
+    x_.clear();
+    y_.clear();
+    radius_.clear();
+    overlapping_.clear();
+}
+
+void CircleBatch::add(uint32_t index, const Circle& circle) {
+    uint32_t lane = indexes_.size();
+    if(lane == x_.size()) {
+        //Padding lanes sit as far away as possible, so the distance to them is always too far
+        uint32_t lanes = lane + CIRCLE_BATCH_LANES;
+        x_.resize(lanes, std::numeric_limits<float>::max());
+        y_.resize(lanes, std::numeric_limits<float>::max());
+        radius_.resize(lanes, 0.0f);
+        overlapping_.resize(lanes, 0);
+    }
+
+    indexes_.push_back(index);
+    x_[lane] = circle.center().x;
+    y_[lane] = circle.center().y;
+    radius_[lane] = circle.radius();
+}
+
+void CircleBatch::find_overlaps(const Circle& circle) {
+    if(indexes_.empty()) {
+        return;
+    }
+
+    const float x = circle.center().x;
+    const float y = circle.center().y;
+    const float radius = circle.radius();
+
+    const float* xs = &x_[0];
+    const float* ys = &y_[0];
+    const float* radii = &radius_[0];
+    uint32_t* overlapping = &overlapping_[0];
+
+    //Rounding up like this (rather than using x_.size()) lets the compiler see there are only whole lanes
+    uint32_t count = (size() + CIRCLE_BATCH_LANES - 1) & ~(CIRCLE_BATCH_LANES - 1);
+
+    for(uint32_t i = 0; i < count; ++i) {
+        float dx = xs[i] - x;
+        float dy = ys[i] - y;
+        float reach = radii[i] + radius;
+        overlapping[i] = ((dx * dx) + (dy * dy)) <= (reach * reach);
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef CIRCLE_BATCH_H
+#define CIRCLE_BATCH_H
+
+#include <vector>
+
+#include "circle.h"
+
+const uint32_t CIRCLE_BATCH_LANES = 8; //The arrays grow by this many circles at a time
+
+/**
+    The centres and radii of a set of circles, kept as one array per
+    coordinate, so that one circle can be tested against all of them in a
+    straight line loop the compiler vectorises. Rings come in fields of dozens,
+    so this is how a circle finds which of its neighbours it actually touches
+    before the narrowphase works out the contacts.
+
+    Circles are added with an index (usually the position of the owning object
+    in the world), and find_overlaps then marks every circle in the batch whose
+    distance from the given one is no more than their radii combined. The
+    arrays are padded to a whole number of lanes with circles that never
+    overlap anything.
+*/
+
+class CircleBatch {
+public:
+    void clear();
+    void add(uint32_t index, const Circle& circle);
+
+    void find_overlaps(const Circle& circle);
+
+    uint32_t size() const { return indexes_.size(); }
+    uint32_t index(uint32_t i) const { return indexes_[i]; }
+    bool overlaps(uint32_t i) const { return overlapping_[i] != 0; }
+
+private:
+    std::vector<uint32_t> indexes_;
+
+    std::vector<float> x_;
+    std::vector<float> y_;
+    std::vector<float> radius_;
+    std::vector<uint32_t> overlapping_;
+};
+
+#endif // CIRCLE_BATCH_H
@@ -1,103 +1,627 @@
 #include <cassert>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
 #include "collide.h"
 
 #include "triangle.h"
 #include "ray_box.h"
 #include "box.h"
+#include "circle.h"
+#include "segment.h"
 
-std::vector<Collision> do_collide(Triangle* triangle, RayBox* ray_box, bool swap_result=false) {
-    std::vector<Collision> collisions;
-    
-    for(char which: { 'A', 'B', 'C', 'D', 'L', 'R', 'Y', 'Z' }) {
-        kmRay2& ray = ray_box->ray(which);
-        
-        kmVec2 intersection, a_normal, b_normal, normal;
-        kmScalar distance; 
+//=================== Sensor collisions =================================
+
+namespace {
+
+/*
+ * The precomputed angle of whichever edge faces along the normal that was hit.
+ * Edges that were never given one (points written directly) fall back to
+ * working it out.
+ */
+SurfaceAngle edge_angle(const kmVec2* normals, const SurfaceAngle* angles, uint32_t count, const kmVec2& normal) {
+    for(uint32_t i = 0; i < count; ++i) {
+        if(kmVec2Dot(&normals[i], &normal) > 0.9999f) {
+            return angles[i];
+        }
+    }
+    return SurfaceAngle::from_normal(normal);
+}
+
+/*
+ * Each of these calls on_hit(sensor, point, normal, angle) for every sensor of
+ * the ray box that hits the shape, where normal is the (normalized) normal of
+ * the surface that was hit and angle is its SurfaceAngle.
+ */
+template<typename Callback>
+void find_sensor_hits(Triangle* triangle, RayBox* ray_box, Callback on_hit) {
+    for(Sensor sensor: { SENSOR_A, SENSOR_B, SENSOR_C, SENSOR_D, SENSOR_L, SENSOR_R }) {
+        kmRay2& ray = ray_box->sensor(sensor);
+
+        kmVec2 intersection, normal;
+        kmScalar distance;
         if(kmRay2IntersectTriangle(&ray, &triangle->point(0),
                                          &triangle->point(1),
                                          &triangle->point(2),
                                          &intersection, &normal, &distance)) {
-                                         
+
             if(distance <= kmVec2Length(&ray.dir)) {
-                Collision new_collision;
-                kmVec2Normalize(&a_normal, &normal);
-                kmVec2Normalize(&b_normal, &ray.dir);
-                
-                new_collision.object_a = (swap_result) ? (CollisionPrimitive*)ray_box : (CollisionPrimitive*)triangle;
-                new_collision.object_b = (swap_result) ? (CollisionPrimitive*)triangle : (CollisionPrimitive*)ray_box;
-                
-                new_collision.a_normal = (swap_result) ? b_normal : a_normal;
-                new_collision.b_normal = (swap_result) ? a_normal : b_normal;
-                new_collision.point = intersection;
-                
-                if(!swap_result){
-                    new_collision.b_ray = which;
-                } else {
-                    new_collision.a_ray = which;
-                }
-                collisions.push_back(new_collision);
+                kmVec2Normalize(&normal, &normal);
+                on_hit(sensor, intersection, normal, edge_angle(triangle->normals(), triangle->angles(), 3, normal));
             }
         }
     }
+}
+
+template<typename Callback>
+void find_sensor_hits(Box* box, RayBox* ray_box, Callback on_hit) {
+    for(Sensor sensor: { SENSOR_A, SENSOR_B, SENSOR_C, SENSOR_D, SENSOR_L, SENSOR_R }) {
+        kmRay2& ray = ray_box->sensor(sensor);
+
+        kmVec2 intersection, normal;
+        if(kmRay2IntersectBox(
+            &ray, &box->point(0), &box->point(1),
+            &box->point(2), &box->point(3),
+            &intersection, &normal)) {
+
+            kmVec2Normalize(&normal, &normal);
+            on_hit(sensor, intersection, normal, edge_angle(box->normals(), box->angles(), 4, normal));
+        }
+    }
+}
+
+//Segments are only solid from the front, so only rays heading into the front can hit them
+bool intersect_segment(const kmRay2& ray, Segment* segment, kmVec2* point) {
+    if(kmVec2Dot(&ray.dir, &segment->normal()) >= 0.0f) {
+        return false;
+    }
+
+    return kmRay2IntersectLineSegment(&ray, &segment->point(0), &segment->point(1), point);
+}
+
+template<typename Callback>
+void find_sensor_hits(Segment* segment, RayBox* ray_box, Callback on_hit) {
+    for(Sensor sensor: { SENSOR_A, SENSOR_B, SENSOR_C, SENSOR_D, SENSOR_L, SENSOR_R }) {
+        kmVec2 intersection;
+        if(intersect_segment(ray_box->sensor(sensor), segment, &intersection)) {
+            on_hit(sensor, intersection, segment->normal(), segment->surface_angle());
+        }
+    }
+}
+
+/*
+ * Where the ray enters the circle, if it does so between start and start + dir.
+ * Rays that start inside the circle don't hit it.
+ */
+bool intersect_circle(const kmRay2& ray, const kmVec2& center, float radius, kmVec2* point, kmVec2* normal) {
+    //Solve |start + dir * t - center| = radius for the point where the ray enters the circle
+    kmVec2 offset;
+    kmVec2Subtract(&offset, &ray.start, &center);
+
+    float a = kmVec2Dot(&ray.dir, &ray.dir);
+    float b = 2.0f * kmVec2Dot(&offset, &ray.dir);
+    float c = kmVec2Dot(&offset, &offset) - (radius * radius);
+
+    float discriminant = (b * b) - (4.0f * a * c);
+    if(a <= 0.0f || discriminant < 0.0f) {
+        return false;
+    }
+
+    float t = (-b - std::sqrt(discriminant)) / (2.0f * a);
+    if(t < 0.0f || t > 1.0f) {
+        return false; //Misses, or starts inside the circle
+    }
+
+    kmVec2Scale(point, &ray.dir, t);
+    kmVec2Add(point, point, &ray.start);
+
+    kmVec2Subtract(normal, point, &center);
+    kmVec2Normalize(normal, normal);
+    return true;
+}
+
+template<typename Callback>
+void find_sensor_hits(Circle* circle, RayBox* ray_box, Callback on_hit) {
+    if(!circle->bounds().overlaps(ray_box->bounds())) {
+        return;
+    }
+
+    for(Sensor sensor: { SENSOR_A, SENSOR_B, SENSOR_C, SENSOR_D, SENSOR_L, SENSOR_R }) {
+        kmVec2 intersection, normal;
+        if(intersect_circle(ray_box->sensor(sensor), circle->center(), circle->radius(), &intersection, &normal)) {
+            on_hit(sensor, intersection, normal, SurfaceAngle::from_normal(normal));
+        }
+    }
+}
+
+/*
+ * The sensors of one ray box against the body of another, so that characters
+ * can push each other and stand on each other's heads.
+ */
+template<typename Callback>
+void find_sensor_hits(RayBox* body, RayBox* sensors, Callback on_hit) {
+    for(Sensor sensor: { SENSOR_A, SENSOR_B, SENSOR_C, SENSOR_D, SENSOR_L, SENSOR_R }) {
+        kmRay2& ray = sensors->sensor(sensor);
+
+        kmVec2 intersection, normal;
+        if(kmRay2IntersectBox(
+            &ray, &body->body_point(0), &body->body_point(1),
+            &body->body_point(2), &body->body_point(3),
+            &intersection, &normal)) {
+
+            kmVec2Normalize(&normal, &normal);
+            on_hit(sensor, intersection, normal, SurfaceAngle::from_normal(normal));
+        }
+    }
+}
+
+/*
+ * Records each sensor hit on the ray box, and also returns them as contacts.
+ * With swap_result the ray box is object_a, otherwise it's object_b.
+ */
+template<typename Shape>
+std::vector<Collision> collide_with_sensors(Shape* shape, RayBox* ray_box, bool swap_result) {
+    std::vector<Collision> collisions;
+
+    find_sensor_hits(shape, ray_box, [&](Sensor sensor, const kmVec2& point, const kmVec2& normal, const SurfaceAngle& angle) {
+        ray_box->record_hit(sensor, point, normal, angle);
+
+        kmVec2 ray_normal;
+        kmVec2Normalize(&ray_normal, &ray_box->sensor(sensor).dir);
+
+        Collision new_collision;
+        new_collision.object_a = (swap_result) ? (CollisionPrimitive*)ray_box : (CollisionPrimitive*)shape;
+        new_collision.object_b = (swap_result) ? (CollisionPrimitive*)shape : (CollisionPrimitive*)ray_box;
+
+        new_collision.a_normal = (swap_result) ? ray_normal : normal;
+        new_collision.b_normal = (swap_result) ? normal : ray_normal;
+        new_collision.point = point;
+
+        if(!swap_result){
+            new_collision.b_ray = SENSOR_NAMES[sensor];
+        } else {
+            new_collision.a_ray = SENSOR_NAMES[sensor];
+        }
+        collisions.push_back(new_collision);
+    });
 
     return collisions;
 }
+
+template<typename Shape>
+void record_sensor_hits(Shape* shape, RayBox* ray_box) {
+    find_sensor_hits(shape, ray_box, [ray_box](Sensor sensor, const kmVec2& point, const kmVec2& normal, const SurfaceAngle& angle) {
+        ray_box->record_hit(sensor, point, normal, angle);
+    });
+}
+
+}
+
+//=================== Triangle - RayBox collisions ======================
+
+std::vector<Collision> do_collide(Triangle* triangle, RayBox* ray_box, bool swap_result=false) {
+    return collide_with_sensors(triangle, ray_box, swap_result);
+}
 std::vector<Collision> do_collide(RayBox* ray_box, Triangle* triangle) { return do_collide(triangle, ray_box, true); }
 
 //=================== Box - RayBox collisions ===========================
 
 std::vector<Collision> do_collide(Box* box, RayBox* ray_box, bool swap_result=false) {
-    std::vector<Collision> collisions;
-    
-    for(char which: { 'A', 'B', 'C', 'D', 'L', 'R' }) {
-        kmRay2& ray = ray_box->ray(which);
-        
-        kmVec2 intersection, a_normal, b_normal, normal;
-        
-        if(kmRay2IntersectBox(
-            &ray, &box->point(0), &box->point(1), 
-            &box->point(2), &box->point(3),
-            &intersection, &normal)) {
-            
-            Collision new_collision;
-            kmVec2Normalize(&a_normal, &normal);
-            kmVec2Normalize(&b_normal, &ray.dir);
-            
-            new_collision.object_a = (swap_result) ? (CollisionPrimitive*)ray_box : (CollisionPrimitive*)box;
-            new_collision.object_b = (swap_result) ? (CollisionPrimitive*)box : (CollisionPrimitive*)ray_box;
-            
-            new_collision.a_normal = (swap_result) ? b_normal : a_normal;
-            new_collision.b_normal = (swap_result) ? a_normal : b_normal;
-            new_collision.point = intersection;
-            
-            if(!swap_result){
-                new_collision.b_ray = which;
-            } else {
-                new_collision.a_ray = which;
+    return collide_with_sensors(box, ray_box, swap_result);
+}
+std::vector<Collision> do_collide(RayBox* ray_box, Box* box) { return do_collide(box, ray_box, true); }
+
+//=================== Segment - RayBox collisions =======================
+
+std::vector<Collision> do_collide(Segment* segment, RayBox* ray_box, bool swap_result=false) {
+    return collide_with_sensors(segment, ray_box, swap_result);
+}
+std::vector<Collision> do_collide(RayBox* ray_box, Segment* segment) { return do_collide(segment, ray_box, true); }
+
+//=================== Polygon - Polygon collisions ======================
+
+namespace {
+
+struct Polygon {
+    CollisionPrimitive* primitive;
+    const kmVec2* points;
+    const kmVec2* normals; //normals[i] is the outward normal of the edge from points[i] to points[i + 1]
+    uint32_t count;
+};
+
+/*
+ * Finds the edge of reference that the other polygon penetrates least. The
+ * separation is negative when they overlap, and positive if the edge is a
+ * separating axis.
+ */
+float find_least_penetration(const Polygon& reference, const Polygon& other, uint32_t& edge) {
+    float best = -std::numeric_limits<float>::max();
+
+    for(uint32_t i = 0; i < reference.count; ++i) {
+        const kmVec2& normal = reference.normals[i];
+        float plane = kmVec2Dot(&normal, &reference.points[i]);
+
+        float deepest = std::numeric_limits<float>::max();
+        for(uint32_t j = 0; j < other.count; ++j) {
+            deepest = std::min(deepest, kmVec2Dot(&normal, &other.points[j]) - plane);
+        }
+
+        if(deepest > best) {
+            best = deepest;
+            edge = i;
+
+            if(best > 0) {
+                break; //Found a separating axis, no need to look any further
             }
-            collisions.push_back(new_collision);
         }
     }
 
+    return best;
+}
+
+/*
+ * Clips the segment in points[0..1] to the side of the plane (normal, offset)
+ * that it's behind. Returns how many points are left.
+ */
+uint32_t clip_segment(kmVec2 points[2], const kmVec2& normal, float offset) {
+    float d0 = kmVec2Dot(&normal, &points[0]) - offset;
+    float d1 = kmVec2Dot(&normal, &points[1]) - offset;
+
+    kmVec2 result[2];
+    uint32_t count = 0;
+
+    if(d0 <= 0) result[count++] = points[0];
+    if(d1 <= 0) result[count++] = points[1];
+
+    if(d0 * d1 < 0) {
+        float t = d0 / (d0 - d1);
+        kmVec2Lerp(&result[count++], &points[0], &points[1], t);
+    }
+
+    points[0] = result[0];
+    points[1] = result[1];
+    return count;
+}
+
+/*
+ * Separating axis test between two convex polygons. If they overlap (or are
+ * touching) this builds a contact manifold of up to two points by clipping
+ * the edge of the incident polygon that faces the reference edge.
+ */
+std::vector<Collision> collide_polygons(const Polygon& a, const Polygon& b) {
+    std::vector<Collision> collisions;
+
+    uint32_t a_edge = 0, b_edge = 0;
+    float a_separation = find_least_penetration(a, b, a_edge);
+    if(a_separation > 0) {
+        return collisions;
+    }
+
+    float b_separation = find_least_penetration(b, a, b_edge);
+    if(b_separation > 0) {
+        return collisions;
+    }
+
+    //Prefer a's edges unless b's are clearly better, so the manifold doesn't flip between steps
+    const float RELATIVE_TOLERANCE = 0.98f;
+    const float ABSOLUTE_TOLERANCE = 0.001f;
+    bool a_is_reference = b_separation <= RELATIVE_TOLERANCE * a_separation + ABSOLUTE_TOLERANCE;
+
+    const Polygon& reference = (a_is_reference) ? a : b;
+    const Polygon& incident = (a_is_reference) ? b : a;
+    uint32_t reference_edge = (a_is_reference) ? a_edge : b_edge;
+
+    const kmVec2& normal = reference.normals[reference_edge];
+
+    //The incident edge is the one facing most directly against the reference normal
+    uint32_t incident_edge = 0;
+    float most_opposed = std::numeric_limits<float>::max();
+    for(uint32_t i = 0; i < incident.count; ++i) {
+        float d = kmVec2Dot(&normal, &incident.normals[i]);
+        if(d < most_opposed) {
+            most_opposed = d;
+            incident_edge = i;
+        }
+    }
+
+    kmVec2 points[2] = {
+        incident.points[incident_edge],
+        incident.points[(incident_edge + 1) % incident.count]
+    };
+
+    //Clip the incident edge to the sides of the reference edge
+    const kmVec2& r1 = reference.points[reference_edge];
+    const kmVec2& r2 = reference.points[(reference_edge + 1) % reference.count];
+
+    kmVec2 tangent;
+    kmVec2Subtract(&tangent, &r2, &r1);
+    kmVec2Normalize(&tangent, &tangent);
+
+    kmVec2 negative_tangent;
+    kmVec2Scale(&negative_tangent, &tangent, -1);
+
+    if(clip_segment(points, tangent, kmVec2Dot(&tangent, &r2)) < 2) {
+        return collisions;
+    }
+
+    if(clip_segment(points, negative_tangent, kmVec2Dot(&negative_tangent, &r1)) < 2) {
+        return collisions;
+    }
+
+    //The normals on each collision face away from their own shape, a_normal points from a to b
+    kmVec2 a_normal = normal;
+    if(!a_is_reference) {
+        kmVec2Scale(&a_normal, &a_normal, -1);
+    }
+
+    kmVec2 b_normal;
+    kmVec2Scale(&b_normal, &a_normal, -1);
+
+    float plane = kmVec2Dot(&normal, &r1);
+    for(const kmVec2& point: points) {
+        float separation = kmVec2Dot(&normal, &point) - plane;
+        if(separation > 0) {
+            continue; //This end of the incident edge is outside the reference polygon
+        }
+
+        Collision new_collision;
+        new_collision.point = point;
+        new_collision.a_normal = a_normal;
+        new_collision.b_normal = b_normal;
+        new_collision.object_a = a.primitive;
+        new_collision.object_b = b.primitive;
+        new_collision.depth = -separation;
+        collisions.push_back(new_collision);
+    }
+
     return collisions;
 }
-std::vector<Collision> do_collide(RayBox* ray_box, Box* box) { return do_collide(box, ray_box, true); }
+
+Polygon make_polygon(Triangle* triangle) {
+    return Polygon{ triangle, triangle->points(), triangle->normals(), 3 };
+}
+
+Polygon make_polygon(Box* box) {
+    return Polygon{ box, box->points(), box->normals(), 4 };
+}
+
+//A segment is a polygon with no thickness, its two sides have opposite normals
+Polygon make_polygon(Segment* segment) {
+    return Polygon{ segment, segment->points(), segment->normals(), 2 };
+}
+
+bool is_in_front(Segment* segment, const kmVec2& point) {
+    kmVec2 offset;
+    kmVec2Subtract(&offset, &point, &segment->point(0));
+    return kmVec2Dot(&offset, &segment->normal()) >= 0.0f;
+}
+
+kmVec2 polygon_centre(const Polygon& polygon) {
+    kmVec2 centre = { 0, 0 };
+    for(uint32_t i = 0; i < polygon.count; ++i) {
+        kmVec2Add(&centre, &centre, &polygon.points[i]);
+    }
+    kmVec2Scale(&centre, &centre, 1.0f / polygon.count);
+    return centre;
+}
+
+}
 
 //=================== Box - Triangle collisions =========================
 
-std::vector<Collision> do_collide(Box* box, Triangle* triangle, bool swap_result=false) {
-    return std::vector<Collision>();
+std::vector<Collision> do_collide(Box* box, Triangle* triangle) {
+    if(!box->bounds().overlaps(triangle->bounds())) {
+        return std::vector<Collision>();
+    }
+
+    return collide_polygons(make_polygon(box), make_polygon(triangle));
+}
+
+std::vector<Collision> do_collide(Triangle* triangle, Box* box) {
+    if(!box->bounds().overlaps(triangle->bounds())) {
+        return std::vector<Collision>();
+    }
+
+    return collide_polygons(make_polygon(triangle), make_polygon(box));
+}
+
+//=================== Box - Segment collisions ==========================
+
+std::vector<Collision> do_collide(Box* box, Segment* segment) {
+    Polygon polygon = make_polygon(box);
+    if(!box->bounds().overlaps(segment->bounds()) || !is_in_front(segment, polygon_centre(polygon))) {
+        return std::vector<Collision>();
+    }
+
+    return collide_polygons(polygon, make_polygon(segment));
+}
+
+std::vector<Collision> do_collide(Segment* segment, Box* box) {
+    Polygon polygon = make_polygon(box);
+    if(!box->bounds().overlaps(segment->bounds()) || !is_in_front(segment, polygon_centre(polygon))) {
+        return std::vector<Collision>();
+    }
+
+    return collide_polygons(make_polygon(segment), polygon);
 }
-std::vector<Collision> do_collide(Triangle* triangle, Box* box) { return do_collide(box, triangle, true); }
 
 //=================== RayBox - RayBox collisions ========================
+
+/*
+ * Each side's hits are tagged with its own ray ID, so each character picks out
+ * the hits from its own sensors when it responds.
+ */
 std::vector<Collision> do_collide(RayBox* a, RayBox* b) {
-    return std::vector<Collision>();
+    if(!a->bounds().overlaps(b->bounds())) {
+        return std::vector<Collision>();
+    }
+
+    std::vector<Collision> collisions = collide_with_sensors(b, a, true);
+    std::vector<Collision> b_collisions = collide_with_sensors(a, b, false);
+    collisions.insert(collisions.end(), b_collisions.begin(), b_collisions.end());
+    return collisions;
 }
 
 //=================== Box - Box collisions ==============================
 std::vector<Collision> do_collide(Box* a, Box* b) {
-    return std::vector<Collision>();
+    if(!a->bounds().overlaps(b->bounds())) {
+        return std::vector<Collision>();
+    }
+
+    return collide_polygons(make_polygon(a), make_polygon(b));
+}
+
+//=================== Circle - RayBox collisions ========================
+
+std::vector<Collision> do_collide(Circle* circle, RayBox* ray_box, bool swap_result=false) {
+    return collide_with_sensors(circle, ray_box, swap_result);
+}
+std::vector<Collision> do_collide(RayBox* ray_box, Circle* circle) { return do_collide(circle, ray_box, true); }
+
+//=================== Circle - Polygon collisions =======================
+
+namespace {
+
+/*
+ * Finds the closest point on the polygon to the centre of the circle, using
+ * the edge that the centre is furthest in front of. If the centre is inside
+ * the polygon it's pushed out through that edge.
+ */
+std::vector<Collision> collide_circle_polygon(Circle* circle, const Polygon& polygon, bool swap_result) {
+    std::vector<Collision> collisions;
+
+    const kmVec2& center = circle->center();
+    float radius = circle->radius();
+
+    uint32_t edge = 0;
+    float separation = -std::numeric_limits<float>::max();
+    for(uint32_t i = 0; i < polygon.count; ++i) {
+        const kmVec2& normal = polygon.normals[i];
+        float s = kmVec2Dot(&normal, &center) - kmVec2Dot(&normal, &polygon.points[i]);
+        if(s > separation) {
+            separation = s;
+            edge = i;
+        }
+    }
+
+    if(separation > radius) {
+        return collisions;
+    }
+
+    //The normal of the polygon's surface, pointing towards the circle
+    kmVec2 normal = polygon.normals[edge];
+    kmVec2 point;
+    float depth;
+
+    if(separation <= 0.0f) {
+        kmVec2 push;
+        kmVec2Scale(&push, &normal, -separation);
+        kmVec2Add(&point, &center, &push);
+        depth = radius - separation;
+    } else {
+        const kmVec2& p1 = polygon.points[edge];
+        const kmVec2& p2 = polygon.points[(edge + 1) % polygon.count];
+
+        kmVec2 along, offset;
+        kmVec2Subtract(&along, &p2, &p1);
+        kmVec2Subtract(&offset, &center, &p1);
+
+        float t = kmVec2Dot(&offset, &along) / kmVec2LengthSq(&along);
+        t = std::max(0.0f, std::min(1.0f, t));
+        kmVec2Lerp(&point, &p1, &p2, t);
+
+        kmVec2 to_center;
+        kmVec2Subtract(&to_center, &center, &point);
+        float distance = kmVec2Length(&to_center);
+        if(distance > radius) {
+            return collisions; //Near a corner, but not touching it
+        }
+
+        if(distance > 0.0f) {
+            kmVec2Scale(&normal, &to_center, 1.0f / distance);
+        }
+        depth = radius - distance;
+    }
+
+    kmVec2 circle_normal;
+    kmVec2Scale(&circle_normal, &normal, -1);
+
+    Collision new_collision;
+    new_collision.point = point;
+    new_collision.object_a = (swap_result) ? (CollisionPrimitive*)circle : polygon.primitive;
+    new_collision.object_b = (swap_result) ? polygon.primitive : (CollisionPrimitive*)circle;
+    new_collision.a_normal = (swap_result) ? circle_normal : normal;
+    new_collision.b_normal = (swap_result) ? normal : circle_normal;
+    new_collision.depth = depth;
+    collisions.push_back(new_collision);
+
+    return collisions;
+}
+
+}
+
+std::vector<Collision> do_collide(Triangle* triangle, Circle* circle, bool swap_result=false) {
+    if(!circle->bounds().overlaps(triangle->bounds())) {
+        return std::vector<Collision>();
+    }
+
+    return collide_circle_polygon(circle, make_polygon(triangle), swap_result);
+}
+std::vector<Collision> do_collide(Circle* circle, Triangle* triangle) { return do_collide(triangle, circle, true); }
+
+std::vector<Collision> do_collide(Box* box, Circle* circle, bool swap_result=false) {
+    if(!circle->bounds().overlaps(box->bounds())) {
+        return std::vector<Collision>();
+    }
+
+    return collide_circle_polygon(circle, make_polygon(box), swap_result);
+}
+std::vector<Collision> do_collide(Circle* circle, Box* box) { return do_collide(box, circle, true); }
+
+std::vector<Collision> do_collide(Segment* segment, Circle* circle, bool swap_result=false) {
+    if(!circle->bounds().overlaps(segment->bounds()) || !is_in_front(segment, circle->center())) {
+        return std::vector<Collision>();
+    }
+
+    return collide_circle_polygon(circle, make_polygon(segment), swap_result);
+}
+std::vector<Collision> do_collide(Circle* circle, Segment* segment) { return do_collide(segment, circle, true); }
+
+//=================== Circle - Circle collisions ========================
+
+std::vector<Collision> do_collide(Circle* a, Circle* b) {
+    std::vector<Collision> collisions;
+
+    kmVec2 between;
+    kmVec2Subtract(&between, &b->center(), &a->center());
+
+    //Compare squared distances, most pairs in a ring field never get as far as the square root
+    float reach = a->radius() + b->radius();
+    float distance_sq = kmVec2LengthSq(&between);
+    if(distance_sq > reach * reach) {
+        return collisions;
+    }
+
+    float distance = std::sqrt(distance_sq);
+
+    Collision new_collision;
+    if(distance > 0.0f) {
+        kmVec2Scale(&new_collision.a_normal, &between, 1.0f / distance);
+    } else {
+        kmVec2Fill(&new_collision.a_normal, 0, 1); //Right on top of each other, push b upwards
+    }
+    kmVec2Scale(&new_collision.b_normal, &new_collision.a_normal, -1);
+
+    kmVec2Scale(&new_collision.point, &new_collision.a_normal, a->radius());
+    kmVec2Add(&new_collision.point, &new_collision.point, &a->center());
+
+    new_collision.object_a = a;
+    new_collision.object_b = b;
+    new_collision.depth = reach - distance;
+    collisions.push_back(new_collision);
+
+    return collisions;
 }
 
 std::vector<Collision> collide(CollisionPrimitive* a, CollisionPrimitive* b) {
@@ -112,12 +636,20 @@ std::vector<Collision> collide(CollisionPrimitive* a, CollisionPrimitive* b) {
             return do_collide(lhs, rhs);
         } else if(Box* rhs = dynamic_cast<Box*>(b)) {
             return do_collide(lhs, rhs);
+        } else if(Circle* rhs = dynamic_cast<Circle*>(b)) {
+            return do_collide(lhs, rhs);
+        } else if(Segment* rhs = dynamic_cast<Segment*>(b)) {
+            return do_collide(lhs, rhs);
         } else {
             assert(0 && "Not implemented");
         }
     } else if (Triangle* lhs = dynamic_cast<Triangle*>(a)) {
         if(RayBox* rhs = dynamic_cast<RayBox*>(b)) {
             return do_collide(lhs, rhs);
+        } else if(Box* rhs = dynamic_cast<Box*>(b)) {
+            return do_collide(lhs, rhs);
+        } else if(Circle* rhs = dynamic_cast<Circle*>(b)) {
+            return do_collide(lhs, rhs);
         } else {
             assert(0 && "Not implemented");
         }   
@@ -128,6 +660,34 @@ std::vector<Collision> collide(CollisionPrimitive* a, CollisionPrimitive* b) {
             return do_collide(lhs, rhs);
         } else if(Box* rhs = dynamic_cast<Box*>(b)) {
             return do_collide(lhs, rhs);
+        } else if(Circle* rhs = dynamic_cast<Circle*>(b)) {
+            return do_collide(lhs, rhs);
+        } else if(Segment* rhs = dynamic_cast<Segment*>(b)) {
+            return do_collide(lhs, rhs);
+        } else {
+            assert(0 && "Not implemented");
+        }
+    } else if (Circle* lhs = dynamic_cast<Circle*>(a)) {
+        if(RayBox* rhs = dynamic_cast<RayBox*>(b)) {
+            return do_collide(lhs, rhs);
+        } else if(Triangle* rhs = dynamic_cast<Triangle*>(b)) {
+            return do_collide(lhs, rhs);
+        } else if(Box* rhs = dynamic_cast<Box*>(b)) {
+            return do_collide(lhs, rhs);
+        } else if(Circle* rhs = dynamic_cast<Circle*>(b)) {
+            return do_collide(lhs, rhs);
+        } else if(Segment* rhs = dynamic_cast<Segment*>(b)) {
+            return do_collide(lhs, rhs);
+        } else {
+            assert(0 && "Not implemented");
+        }
+    } else if (Segment* lhs = dynamic_cast<Segment*>(a)) {
+        if(RayBox* rhs = dynamic_cast<RayBox*>(b)) {
+            return do_collide(lhs, rhs);
+        } else if(Box* rhs = dynamic_cast<Box*>(b)) {
+            return do_collide(lhs, rhs);
+        } else if(Circle* rhs = dynamic_cast<Circle*>(b)) {
+            return do_collide(lhs, rhs);
         } else {
             assert(0 && "Not implemented");
         }
@@ -135,3 +695,57 @@ std::vector<Collision> collide(CollisionPrimitive* a, CollisionPrimitive* b) {
         assert(0 && "Not implemented");
     }        
 }
+
+void collide_sensors(RayBox* ray_box, CollisionPrimitive* other) {
+    if(RayBox* rhs = dynamic_cast<RayBox*>(other)) {
+        if(ray_box->bounds().overlaps(rhs->bounds())) {
+            record_sensor_hits(rhs, ray_box);
+        }
+    } else if(Triangle* rhs = dynamic_cast<Triangle*>(other)) {
+        record_sensor_hits(rhs, ray_box);
+    } else if(Box* rhs = dynamic_cast<Box*>(other)) {
+        record_sensor_hits(rhs, ray_box);
+    } else if(Circle* rhs = dynamic_cast<Circle*>(other)) {
+        record_sensor_hits(rhs, ray_box);
+    } else if(Segment* rhs = dynamic_cast<Segment*>(other)) {
+        record_sensor_hits(rhs, ray_box);
+    } else {
+        assert(0 && "Not implemented");
+    }
+}
+
+bool ray_cast(const kmRay2& ray, CollisionPrimitive* primitive, kmVec2* point, kmVec2* normal) {
+    bool hit = false;
+
+    if(RayBox* ray_box = dynamic_cast<RayBox*>(primitive)) {
+        hit = kmRay2IntersectBox(
+            &ray, &ray_box->body_point(0), &ray_box->body_point(1),
+            &ray_box->body_point(2), &ray_box->body_point(3),
+            point, normal
+        );
+    } else if(Triangle* triangle = dynamic_cast<Triangle*>(primitive)) {
+        kmScalar distance;
+        hit = kmRay2IntersectTriangle(
+            &ray, &triangle->point(0), &triangle->point(1), &triangle->point(2),
+            point, normal, &distance
+        ) && distance <= kmVec2Length(&ray.dir);
+    } else if(Box* box = dynamic_cast<Box*>(primitive)) {
+        hit = kmRay2IntersectBox(
+            &ray, &box->point(0), &box->point(1),
+            &box->point(2), &box->point(3),
+            point, normal
+        );
+    } else if(Circle* circle = dynamic_cast<Circle*>(primitive)) {
+        return intersect_circle(ray, circle->center(), circle->radius(), point, normal);
+    } else if(Segment* segment = dynamic_cast<Segment*>(primitive)) {
+        *normal = segment->normal();
+        return intersect_segment(ray, segment, point);
+    } else {
+        assert(0 && "Not implemented");
+    }
+
+    if(hit) {
+        kmVec2Normalize(normal, normal);
+    }
+    return hit;
+}
@@ -1,9 +1,24 @@
 #ifndef COLLIDE_H
 #define COLLIDE_H
 
+#include "kazmath/ray2.h"
 #include "collision_primitive.h"
 
+class RayBox;
+
 std::vector<Collision> collide(CollisionPrimitive* a, CollisionPrimitive* b);
 
+/*
+ * Only records the nearest hit of each of the ray box's sensors against other,
+ * without building any contacts. Nothing is recorded on other.
+ */
+void collide_sensors(RayBox* ray_box, CollisionPrimitive* other);
+
+/*
+ * Finds where the ray (from start to start + dir) first enters the primitive,
+ * and the normal of the surface there. Ray boxes are hit on their body.
+ */
+bool ray_cast(const kmRay2& ray, CollisionPrimitive* primitive, kmVec2* point, kmVec2* normal);
+
 #endif
 
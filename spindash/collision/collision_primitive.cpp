@@ -1,5 +1,57 @@
+#include <cmath>
+
 #include "collision_primitive.h"
 
+#include "kazmath/utility.h"
+
 CollisionPrimitive::~CollisionPrimitive() {
 
 }
+
+SurfaceAngle SurfaceAngle::from_normal(const kmVec2& normal) {
+    float degrees = kmRadiansToDegrees(std::atan2(normal.x, normal.y));
+    if(degrees < 0) {
+        degrees += 360.0f;
+    }
+
+    return from_degrees(degrees);
+}
+
+SurfaceAngle SurfaceAngle::from_degrees(float degrees) {
+    SurfaceAngle result;
+    result.degrees = degrees;
+    result.sin = std::sin(kmDegreesToRadians(degrees));
+    result.cos = std::cos(kmDegreesToRadians(degrees));
+    return result;
+}
+
+void calculate_edge_angles(const kmVec2* normals, uint32_t count, SurfaceAngle* angles) {
+    for(uint32_t i = 0; i < count; ++i) {
+        angles[i] = SurfaceAngle::from_normal(normals[i]);
+    }
+}
+
+void calculate_edge_normals(const kmVec2* points, uint32_t count, kmVec2* normals) {
+    kmVec2 centre = { 0, 0 };
+    for(uint32_t i = 0; i < count; ++i) {
+        kmVec2Add(&centre, &centre, &points[i]);
+    }
+    kmVec2Scale(&centre, &centre, 1.0f / count);
+
+    for(uint32_t i = 0; i < count; ++i) {
+        const kmVec2& start = points[i];
+        const kmVec2& end = points[(i + 1) % count];
+
+        kmVec2 edge;
+        kmVec2Subtract(&edge, &end, &start);
+        kmVec2Fill(&normals[i], edge.y, -edge.x);
+        kmVec2Normalize(&normals[i], &normals[i]);
+
+        //Flip anything that points back towards the middle
+        kmVec2 outwards;
+        kmVec2Subtract(&outwards, &start, &centre);
+        if(kmVec2Dot(&normals[i], &outwards) < 0) {
+            kmVec2Scale(&normals[i], &normals[i], -1);
+        }
+    }
+}
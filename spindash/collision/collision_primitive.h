@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <memory>
+#include <cstdint>
 #include "kazmath/vec2.h"
 
 class Object;
@@ -14,13 +15,69 @@ struct Collision {
     kmVec2 a_normal; //The normal of the surface on object_a that collided
     kmVec2 b_normal; //The normal of the surface on object_b that collided
     
-    CollisionPrimitive* object_a;
-    CollisionPrimitive* object_b;
+    CollisionPrimitive* object_a = nullptr;
+    CollisionPrimitive* object_b = nullptr;
     
-    char a_ray; //The ID of the ray that caused this collision, only used for ray-boxes
-    char b_ray;
+    char a_ray = 0; //The ID of the ray that caused this collision, only used for ray-boxes
+    char b_ray = 0;
+
+    float depth = 0.0f; //How far the shapes overlap along the normals, ray hits don't have a depth
+};
+
+struct AABB {
+    kmVec2 min;
+    kmVec2 max;
+
+    bool overlaps(const AABB& other) const {
+        return min.x <= other.max.x && max.x >= other.min.x &&
+               min.y <= other.max.y && max.y >= other.min.y;
+    }
+
+    void include(const kmVec2& point) {
+        if(point.x < min.x) min.x = point.x;
+        if(point.y < min.y) min.y = point.y;
+        if(point.x > max.x) max.x = point.x;
+        if(point.y > max.y) max.y = point.y;
+    }
+
+    ///Grows the box so that it covers everything it touches while moving by motion
+    void sweep(const kmVec2& motion) {
+        if(motion.x < 0) min.x += motion.x; else max.x += motion.x;
+        if(motion.y < 0) min.y += motion.y; else max.y += motion.y;
+    }
+
+    static AABB from_points(const kmVec2* points, uint32_t count) {
+        AABB result;
+        result.min = result.max = points[0];
+        for(uint32_t i = 1; i < count; ++i) {
+            result.include(points[i]);
+        }
+        return result;
+    }
+};
+
+/*
+ * The angle of a surface, in degrees clockwise from straight up, with its sine
+ * and cosine. Static geometry works these out for each edge when it's built so
+ * that characters walking on it don't have to every step.
+ */
+struct SurfaceAngle {
+    float degrees = 0.0f;
+    float sin = 0.0f;
+    float cos = 1.0f;
+
+    static SurfaceAngle from_normal(const kmVec2& normal);
+    static SurfaceAngle from_degrees(float degrees);
 };
 
+void calculate_edge_angles(const kmVec2* normals, uint32_t count, SurfaceAngle* angles);
+
+/*
+ * Fills normals[i] with the outward facing unit normal of the edge from
+ * points[i] to points[i + 1] (wrapping around), whatever the winding
+ */
+void calculate_edge_normals(const kmVec2* points, uint32_t count, kmVec2* normals);
+
 class CollisionPrimitive {
 public:
     typedef std::shared_ptr<CollisionPrimitive> ptr;
@@ -32,8 +89,10 @@ public:
 
     virtual void set_position(float x, float y) = 0;
     virtual void set_rotation(float degrees) = 0;
+    virtual AABB bounds() const = 0;
     
     Object* owner() { return owner_; }
+    void set_owner(Object* owner) { owner_ = owner; }
     
 private:
     Object* owner_;    
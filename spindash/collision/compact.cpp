@@ -0,0 +1,480 @@
+#include <cmath>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+
+#include "compact.h"
+
+//Points this close to a line count as on it, even with no weld tolerance
+const float MIN_COLLINEAR_TOLERANCE = 0.00001f;
+
+namespace {
+
+/*
+ * A triangle or a box during compaction, as indexes into the welded vertices.
+ * The vertices always go anticlockwise so neighbours share edges in opposite
+ * directions.
+ */
+struct Piece {
+    uint32_t vertices[4];
+    uint32_t count;
+
+    bool is_box; //Whether the source is in the boxes or the triangles
+    uint32_t source;
+    bool changed;
+    bool removed;
+};
+
+struct Merge {
+    uint32_t keep;
+    uint32_t drop;
+    std::vector<uint32_t> vertices;
+    float shared_length;
+};
+
+/*
+ * Hands out one index per distinct vertex, anything within the tolerance of a
+ * vertex that has already been seen gets that vertex's index. The first vertex
+ * seen wins, so the result only depends on the order of the triangles.
+ */
+class VertexWelder {
+public:
+    VertexWelder(float tolerance):
+        tolerance_(tolerance),
+        cell_size_((tolerance > 0.0f) ? tolerance : 1.0f) {}
+
+    uint32_t weld(const kmVec2& point) {
+        int32_t x = cell_coordinate(point.x);
+        int32_t y = cell_coordinate(point.y);
+
+        //The cells are as big as the tolerance, so any match is in this cell or a neighbour
+        for(int32_t dx = -1; dx <= 1; ++dx) {
+            for(int32_t dy = -1; dy <= 1; ++dy) {
+                auto it = cells_.find(cell_key(x + dx, y + dy));
+                if(it == cells_.end()) {
+                    continue;
+                }
+
+                for(uint32_t i: it->second) {
+                    if(kmVec2DistanceBetween(&vertices_[i], &point) <= tolerance_) {
+                        return i;
+                    }
+                }
+            }
+        }
+
+        uint32_t index = vertices_.size();
+        vertices_.push_back(point);
+        cells_[cell_key(x, y)].push_back(index);
+        return index;
+    }
+
+    const kmVec2& vertex(uint32_t i) const { return vertices_[i]; }
+
+private:
+    float tolerance_;
+    float cell_size_;
+
+    std::vector<kmVec2> vertices_;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells_;
+
+    int32_t cell_coordinate(float value) const {
+        return int32_t(std::floor(value / cell_size_));
+    }
+
+    static uint64_t cell_key(int32_t x, int32_t y) {
+        return (uint64_t(uint32_t(x)) << 32) | uint32_t(y);
+    }
+};
+
+float distance_from_line(const kmVec2& point, const kmVec2& start, const kmVec2& end) {
+    kmVec2 line, offset;
+    kmVec2Subtract(&line, &end, &start);
+    kmVec2Subtract(&offset, &point, &start);
+
+    float length = kmVec2Length(&line);
+    if(length <= 0.0f) {
+        return kmVec2Length(&offset);
+    }
+
+    return std::fabs(kmVec2Cross(&line, &offset)) / length;
+}
+
+bool is_thinner_than(const kmVec2* points, float tolerance) {
+    float longest = 0.0f;
+    uint32_t base = 0;
+    for(uint32_t i = 0; i < 3; ++i) {
+        float length = kmVec2DistanceBetween(&points[i], &points[(i + 1) % 3]);
+        if(length > longest) {
+            longest = length;
+            base = i;
+        }
+    }
+
+    //The height over the longest edge is the thinnest the triangle gets
+    return distance_from_line(points[(base + 2) % 3], points[base], points[(base + 1) % 3]) <= tolerance;
+}
+
+//Whether point lies on the line between start and end, and not at either end of it
+bool is_between(const kmVec2& point, const kmVec2& start, const kmVec2& end, float tolerance) {
+    kmVec2 line, offset;
+    kmVec2Subtract(&line, &end, &start);
+    kmVec2Subtract(&offset, &point, &start);
+
+    float along = kmVec2Dot(&offset, &line);
+    if(along <= 0.0f || along >= kmVec2LengthSq(&line)) {
+        return false;
+    }
+
+    return distance_from_line(point, start, end) <= tolerance;
+}
+
+float signed_area(const std::vector<kmVec2>& points) {
+    float area = 0.0f;
+    for(uint32_t i = 0; i < points.size(); ++i) {
+        area += kmVec2Cross(&points[i], &points[(i + 1) % points.size()]);
+    }
+    return area * 0.5f;
+}
+
+class Compactor {
+public:
+    Compactor(float weld_tolerance):
+        weld_tolerance_(weld_tolerance),
+        collinear_tolerance_(std::max(weld_tolerance, MIN_COLLINEAR_TOLERANCE)),
+        welder_(weld_tolerance) {}
+
+    void add(const kmVec2* points, uint32_t count, bool is_box, uint32_t source) {
+        Piece piece;
+        piece.count = count;
+        piece.is_box = is_box;
+        piece.source = source;
+        piece.changed = false;
+
+        std::vector<kmVec2> welded(count);
+        for(uint32_t i = 0; i < count; ++i) {
+            piece.vertices[i] = welder_.weld(points[i]);
+            welded[i] = welder_.vertex(piece.vertices[i]);
+
+            if(welded[i].x != points[i].x || welded[i].y != points[i].y) {
+                piece.changed = true;
+            }
+        }
+
+        if(signed_area(welded) < 0.0f) {
+            std::reverse(piece.vertices, piece.vertices + count);
+        }
+
+        piece.removed = (count == 3 && is_thinner_than(&welded[0], weld_tolerance_));
+        pieces_.push_back(piece);
+    }
+
+    bool merge_pass();
+
+    const std::vector<Piece>& pieces() const { return pieces_; }
+    const kmVec2& vertex(uint32_t i) const { return welder_.vertex(i); }
+
+private:
+    float weld_tolerance_;
+    float collinear_tolerance_;
+
+    VertexWelder welder_;
+    std::vector<Piece> pieces_;
+
+    bool find_union(const Piece& a, uint32_t a_edge, const Piece& b, uint32_t b_edge, std::vector<uint32_t>& result) const;
+};
+
+/*
+ * The outline of two pieces joined across a shared edge, with any corners
+ * that end up on a straight line removed. Only succeeds if that outline is a
+ * convex triangle or box.
+ */
+bool Compactor::find_union(const Piece& a, uint32_t a_edge, const Piece& b, uint32_t b_edge, std::vector<uint32_t>& result) const {
+    result.clear();
+
+    //All the way round a starting at the end of the shared edge, then the rest of b
+    for(uint32_t i = 1; i <= a.count; ++i) {
+        result.push_back(a.vertices[(a_edge + i) % a.count]);
+    }
+
+    for(uint32_t i = 2; i < b.count; ++i) {
+        result.push_back(b.vertices[(b_edge + i) % b.count]);
+    }
+
+    bool removed = true;
+    while(removed && result.size() > 3) {
+        removed = false;
+
+        for(uint32_t i = 0; i < result.size(); ++i) {
+            const kmVec2& previous = vertex(result[(i + result.size() - 1) % result.size()]);
+            const kmVec2& next = vertex(result[(i + 1) % result.size()]);
+
+            if(is_between(vertex(result[i]), previous, next, collinear_tolerance_)) {
+                result.erase(result.begin() + i);
+                removed = true;
+                break;
+            }
+        }
+    }
+
+    if(result.size() > 4) {
+        return false;
+    }
+
+    for(uint32_t i = 0; i < result.size(); ++i) {
+        const kmVec2& p0 = vertex(result[i]);
+        const kmVec2& p1 = vertex(result[(i + 1) % result.size()]);
+        const kmVec2& p2 = vertex(result[(i + 2) % result.size()]);
+
+        kmVec2 e0, e1;
+        kmVec2Subtract(&e0, &p1, &p0);
+        kmVec2Subtract(&e1, &p2, &p1);
+        if(kmVec2Cross(&e0, &e1) <= 0.0f) {
+            return false; //Not convex, or folds back on itself
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Finds every pair of pieces that could be joined into one, then joins them
+ * across the longest shared edges first. Those are the interior edges that
+ * cut furthest across the geometry, like the diagonals of tiles, and joining
+ * them first leaves the pieces lined up to join again in the next pass.
+ */
+bool Compactor::merge_pass() {
+    typedef std::pair<uint32_t, uint32_t> Edge;
+    typedef std::pair<uint32_t, uint32_t> PieceEdge;
+
+    std::map<Edge, std::vector<PieceEdge>> edges;
+    for(uint32_t i = 0; i < pieces_.size(); ++i) {
+        const Piece& piece = pieces_[i];
+        if(piece.removed) {
+            continue;
+        }
+
+        for(uint32_t j = 0; j < piece.count; ++j) {
+            uint32_t u = piece.vertices[j];
+            uint32_t v = piece.vertices[(j + 1) % piece.count];
+            if(u != v) {
+                edges[Edge(std::min(u, v), std::max(u, v))].push_back(PieceEdge(i, j));
+            }
+        }
+    }
+
+    std::vector<Merge> merges;
+    std::vector<uint32_t> vertices;
+
+    for(auto& entry: edges) {
+        if(entry.second.size() != 2) {
+            continue; //An outside edge, or overlapping geometry which we leave alone
+        }
+
+        const PieceEdge& first = entry.second[0];
+        const PieceEdge& second = entry.second[1];
+        if(first.first == second.first) {
+            continue;
+        }
+
+        const Piece& a = pieces_[first.first];
+        const Piece& b = pieces_[second.first];
+
+        //Neighbours go round opposite ways, if they don't the pieces overlap
+        if(a.vertices[first.second] != b.vertices[(second.second + 1) % b.count]) {
+            continue;
+        }
+
+        if(!find_union(a, first.second, b, second.second, vertices)) {
+            continue;
+        }
+
+        Merge merge;
+        merge.keep = first.first;
+        merge.drop = second.first;
+        merge.vertices = vertices;
+        merge.shared_length = kmVec2DistanceBetween(&vertex(entry.first.first), &vertex(entry.first.second));
+        merges.push_back(merge);
+    }
+
+    std::stable_sort(merges.begin(), merges.end(), [](const Merge& lhs, const Merge& rhs) {
+        return lhs.shared_length > rhs.shared_length;
+    });
+
+    std::vector<bool> merged(pieces_.size(), false);
+    bool any_merged = false;
+
+    for(const Merge& merge: merges) {
+        if(merged[merge.keep] || merged[merge.drop]) {
+            continue;
+        }
+
+        Piece& keep = pieces_[merge.keep];
+        std::copy(merge.vertices.begin(), merge.vertices.end(), keep.vertices);
+        keep.count = merge.vertices.size();
+        keep.changed = true;
+
+        pieces_[merge.drop].removed = true;
+
+        merged[merge.keep] = merged[merge.drop] = true;
+        any_merged = true;
+    }
+
+    return any_merged;
+}
+
+}
+
+void compact_geometry(std::vector<Triangle>& triangles, std::vector<Box>& boxes, float weld_tolerance,
+    std::vector<uint32_t>& changed_triangles, std::vector<uint32_t>& changed_boxes) {
+
+    Compactor compactor(weld_tolerance);
+
+    for(uint32_t i = 0; i < triangles.size(); ++i) {
+        compactor.add(triangles[i].points(), 3, false, i);
+    }
+
+    for(uint32_t i = 0; i < boxes.size(); ++i) {
+        compactor.add(boxes[i].points(), 4, true, i);
+    }
+
+    while(compactor.merge_pass()) {}
+
+    std::vector<Triangle> new_triangles;
+    std::vector<Box> new_boxes;
+
+    changed_triangles.clear();
+    changed_boxes.clear();
+
+    for(const Piece& piece: compactor.pieces()) {
+        if(piece.removed) {
+            continue;
+        }
+
+        const uint32_t* v = piece.vertices;
+
+        if(piece.count == 3) {
+            if(!piece.changed && !piece.is_box) {
+                new_triangles.push_back(triangles[piece.source]);
+                continue;
+            }
+
+            Triangle triangle;
+            triangle.set_points(compactor.vertex(v[0]), compactor.vertex(v[1]), compactor.vertex(v[2]));
+            changed_triangles.push_back(new_triangles.size());
+            new_triangles.push_back(triangle);
+        } else {
+            if(!piece.changed && piece.is_box) {
+                new_boxes.push_back(boxes[piece.source]);
+                continue;
+            }
+
+            Box box;
+            box.set_points(compactor.vertex(v[0]), compactor.vertex(v[1]), compactor.vertex(v[2]), compactor.vertex(v[3]));
+            changed_boxes.push_back(new_boxes.size());
+            new_boxes.push_back(box);
+        }
+    }
+
+    triangles.swap(new_triangles);
+    boxes.swap(new_boxes);
+}
+
+std::vector<Segment> mesh_surfaces(const kmVec2* points, uint32_t num_triangles, float weld_tolerance) {
+    VertexWelder welder(weld_tolerance);
+
+    typedef std::pair<uint32_t, uint32_t> Edge;
+
+    //Every edge of every triangle, going round them anticlockwise
+    std::vector<Edge> directed;
+    std::map<Edge, uint32_t> uses;
+
+    for(uint32_t i = 0; i < num_triangles; ++i) {
+        const kmVec2* triangle = points + (i * 3);
+
+        uint32_t vertices[3];
+        std::vector<kmVec2> welded(3);
+        for(uint32_t j = 0; j < 3; ++j) {
+            vertices[j] = welder.weld(triangle[j]);
+            welded[j] = welder.vertex(vertices[j]);
+        }
+
+        if(is_thinner_than(&welded[0], weld_tolerance)) {
+            continue;
+        }
+
+        if(signed_area(welded) < 0.0f) {
+            std::swap(vertices[1], vertices[2]);
+        }
+
+        for(uint32_t j = 0; j < 3; ++j) {
+            uint32_t u = vertices[j];
+            uint32_t v = vertices[(j + 1) % 3];
+            directed.push_back(Edge(u, v));
+            ++uses[Edge(std::min(u, v), std::max(u, v))];
+        }
+    }
+
+    /*
+     * Edges shared by two triangles are inside the mesh, so only the rest are
+     * kept. The inside of each triangle is to the left of its edges, so they're
+     * flipped to face outwards.
+     */
+    std::vector<Edge> outline;
+    std::map<uint32_t, std::vector<uint32_t>> starting_at;
+    std::map<uint32_t, uint32_t> ending_at;
+
+    for(const Edge& edge: directed) {
+        if(uses[Edge(std::min(edge.first, edge.second), std::max(edge.first, edge.second))] != 1) {
+            continue;
+        }
+
+        starting_at[edge.second].push_back(outline.size());
+        ++ending_at[edge.first];
+        outline.push_back(Edge(edge.second, edge.first));
+    }
+
+    //Join up runs of surfaces that carry on in a straight line
+    float collinear_tolerance = std::max(weld_tolerance, MIN_COLLINEAR_TOLERANCE);
+    std::vector<bool> joined(outline.size(), false);
+
+    for(uint32_t i = 0; i < outline.size(); ++i) {
+        if(joined[i]) {
+            continue;
+        }
+
+        Edge& edge = outline[i];
+        while(true) {
+            auto next_it = starting_at.find(edge.second);
+            if(next_it == starting_at.end() || next_it->second.size() != 1 || ending_at[edge.second] != 1) {
+                break; //The outline branches here, or stops
+            }
+
+            uint32_t next = next_it->second[0];
+            if(next == i || joined[next]) {
+                break;
+            }
+
+            const Edge& next_edge = outline[next];
+            if(!is_between(welder.vertex(edge.second), welder.vertex(edge.first), welder.vertex(next_edge.second), collinear_tolerance)) {
+                break;
+            }
+
+            edge.second = next_edge.second;
+            joined[next] = true;
+        }
+    }
+
+    std::vector<Segment> result;
+    for(uint32_t i = 0; i < outline.size(); ++i) {
+        if(joined[i]) {
+            continue;
+        }
+
+        Segment segment;
+        segment.set_points(welder.vertex(outline[i].first), welder.vertex(outline[i].second));
+        result.push_back(segment);
+    }
+
+    return result;
+}
@@ -0,0 +1,42 @@
+#ifndef COMPACT_H
+#define COMPACT_H
+
+#include <vector>
+
+#include "triangle.h"
+#include "box.h"
+#include "segment.h"
+
+/**
+    Reduces the number of pieces of static geometry without changing its shape.
+
+    Vertices closer together than the weld tolerance are snapped to the same
+    place, which closes the hairline gaps that exporters leave between tiles,
+    and triangles that end up thinner than the tolerance are dropped. Then any
+    two pieces that share an edge are joined if together they make a convex
+    triangle or box. Corners left in the middle of a straight edge are removed,
+    so flat runs of tiles end up as one long surface, and the interior edges
+    between them (which no sensor outside the geometry can reach) are gone.
+
+    Curved surfaces, like the fans built by sdWorldConstructLoop, are left alone
+    because joining them would change their shape.
+
+    The lists are replaced with the compacted geometry, which can turn
+    triangles into boxes. changed_triangles and changed_boxes are filled with
+    the indexes of the new pieces whose geometry handles are no longer valid,
+    anything that wasn't changed keeps its handle but may have moved.
+*/
+
+void compact_geometry(std::vector<Triangle>& triangles, std::vector<Box>& boxes, float weld_tolerance,
+    std::vector<uint32_t>& changed_triangles, std::vector<uint32_t>& changed_boxes);
+
+/**
+    Converts a triangle mesh (num_triangles * 3 points) into the one-sided
+    surfaces around its outline, facing out of the mesh. Edges shared by two
+    triangles are inside the mesh and are dropped, and surfaces that carry on
+    in a straight line are joined into one.
+*/
+
+std::vector<Segment> mesh_surfaces(const kmVec2* points, uint32_t num_triangles, float weld_tolerance);
+
+#endif // COMPACT_H
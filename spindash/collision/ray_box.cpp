@@ -1,89 +1,173 @@
+#include <map>
+#include <tuple>
+#include <mutex>
+#include <cassert>
 
 #include "ray_box.h"
 #include "kazmath/ray2.h"
 #include "kazmath/mat3.h"
 
+static Sensor sensor_from_name(char which) {
+    switch(which) {
+        case 'A': return SENSOR_A;
+        case 'B': return SENSOR_B;
+        case 'C': return SENSOR_C;
+        case 'D': return SENSOR_D;
+        case 'E': return SENSOR_E;
+        case 'L': return SENSOR_L;
+        case 'R': return SENSOR_R;
+        default:
+            assert(0 && "Not a ray box sensor");
+            return SENSOR_MAX;
+    }
+}
+
+std::shared_ptr<const SensorTemplate> SensorTemplate::get(float width, float height, float degrees) {
+    /*
+     * Each character only uses a handful of these (four quadrants and two
+     * sizes), so they're shared between every ray box of the same shape.
+     * They're immutable once built, but the cache is shared by every world
+     * and worlds can be stepped on different threads, so it's locked. It only
+     * holds on to the templates that some ray box is still using, otherwise
+     * it would keep one for every size that was ever asked for.
+     */
+    typedef std::tuple<float, float, float> Key;
+    static std::map<Key, std::weak_ptr<const SensorTemplate>> templates;
+    static std::mutex templates_mutex;
+
+    std::lock_guard<std::mutex> lock(templates_mutex);
+
+    Key key(width, height, degrees);
+    auto it = templates.find(key);
+    if(it != templates.end()) {
+        if(auto existing = it->second.lock()) {
+            return existing;
+        }
+    }
+
+    //FIXME: Rotation!!
+    //TODO: Fix all the ray positions to match the Sonic Physics Guide
+
+    auto result = std::make_shared<SensorTemplate>();
+    kmRay2* rays = result->rays;
+
+    kmRay2& l = rays[SENSOR_L];
+    kmVec2Fill(&l.start, 0, -((height / 2.0) * 0.2)); //FIXME: Y-pos should be below center, and isn't rotated
+    kmVec2Fill(&l.dir, -(width/2), 0.0f);
+    kmVec2RotateBy(&l.dir, &l.dir, degrees, &KM_VEC2_ZERO);
+
+    kmRay2& r = rays[SENSOR_R];
+    kmVec2Fill(&r.start, 0, -((height / 2.0) * 0.2)); //FIXME: Y-pos should be below center, and isn't rotated
+    kmVec2Fill(&r.dir, (width/2), 0.0f);
+    kmVec2RotateBy(&r.dir, &r.dir, degrees, &KM_VEC2_ZERO);
+
+    kmRay2& a = rays[SENSOR_A];
+    kmVec2Fill(&a.start, -(width / 2.0) * 0.9, 0.0f);
+    kmVec2Fill(&a.dir, 0, -height / 2.0f);
+
+    kmRay2& b = rays[SENSOR_B];
+    kmVec2Fill(&b.start, (width / 2.0) * 0.9, 0.0f);
+    kmVec2Fill(&b.dir, 0, -height /2.0f);
+
+    kmRay2& c = rays[SENSOR_C];
+    kmVec2Fill(&c.start, -(width / 2.0) * 0.9, 0.0f);
+    kmVec2Fill(&c.dir, 0, height / 2.0f);
+
+    kmRay2& d = rays[SENSOR_D];
+    kmVec2Fill(&d.start, (width / 2.0) * 0.9, 0.0f);
+    kmVec2Fill(&d.dir, 0, height / 2.0f);
+
+    kmRay2& e = rays[SENSOR_E];
+    kmVec2Fill(&e.start, 0, 0);
+    kmVec2Fill(&e.dir, 0, -(height / 2.0));
+
+    for(kmRay2* ray: { &a, &b, &c, &d, &e }) {
+        kmVec2RotateBy(&ray->start, &ray->start, degrees, &KM_VEC2_ZERO);
+        kmVec2RotateBy(&ray->dir, &ray->dir, degrees, &KM_VEC2_ZERO);
+    }
+
+    for(auto it = templates.begin(); it != templates.end();) {
+        it = (it->second.expired()) ? templates.erase(it) : std::next(it);
+    }
+
+    templates[key] = result;
+    return result;
+}
+
 RayBox::RayBox(Object* owner, float width, float height):
     CollisionPrimitive(owner),
     x_(0.0f),
     y_(0.0f),
     width_(width),
     height_(height),
-    degrees_(0.0f) {
+    degrees_(0.0f),
+    body_width_(width),
+    body_height_(height) {
     
     init();
 }
 
 const kmRay2& RayBox::ray(char which) const {
-    return rays_.find(which)->second;
+    return rays_[sensor_from_name(which)];
 }
 
 kmRay2& RayBox::ray(char which) {
-    //FIXME: assert(which in { 'A', 'B', 'C', 'D', 'L', 'R' })
-    return rays_[which];
+    return rays_[sensor_from_name(which)];
 }
 
 void RayBox::init() {
-    //FIXME: Rotation!!
-    //TODO: Fix all the ray positions to match the Sonic Physics Guide
-    
+    template_ = SensorTemplate::get(width_, height_, degrees_);
 
-    float rotation = this->degrees_;
+    float hw = body_width_ * 0.5f;
+    float hh = body_height_ * 0.5f;
+    kmVec2Fill(&local_body_[0], -hw, -hh);
+    kmVec2Fill(&local_body_[1], hw, -hh);
+    kmVec2Fill(&local_body_[2], hw, hh);
+    kmVec2Fill(&local_body_[3], -hw, hh);
 
-    kmRay2& l = rays_['L'];
-    kmVec2Fill(&l.start, x_, y_ - ((height_ / 2.0) * 0.2)); //FIXME: Y-pos should be below center
-    kmVec2Fill(&l.dir, -(width_/2), 0.0f);
-    kmVec2RotateBy(&l.dir, &l.dir, rotation, &KM_VEC2_ZERO);
-    
-    kmRay2& r = rays_['R'];
-    kmVec2Fill(&r.start, x_, y_ - ((height_ / 2.0) * 0.2)); //FIXME: Y-pos should be below center
-    kmVec2Fill(&r.dir, (width_/2), 0.0f); 
-    kmVec2RotateBy(&r.dir, &r.dir, rotation, &KM_VEC2_ZERO);
-    
-    kmRay2& a = rays_['A'];
-    kmVec2Fill(&a.start, -(width_ / 2.0) * 0.9, 0.0f); 
-    kmVec2Fill(&a.dir, 0, -height_ / 2.0f);
-    
-    kmVec2RotateBy(&a.start, &a.start, rotation, &KM_VEC2_ZERO);
-    a.start.x += x_; a.start.y += y_;
-    kmVec2RotateBy(&a.dir, &a.dir, rotation, &KM_VEC2_ZERO);
-    
-    kmRay2& b = rays_['B'];
-    kmVec2Fill(&b.start, (width_ / 2.0) * 0.9, 0.0f); 
-    kmVec2Fill(&b.dir, 0, -height_ /2.0f);
-    
-    kmVec2RotateBy(&b.start, &b.start, rotation, &KM_VEC2_ZERO);
-    b.start.x += x_; b.start.y += y_;
-    kmVec2RotateBy(&b.dir, &b.dir, rotation, &KM_VEC2_ZERO);
-        
-    kmRay2& c = rays_['C'];
-    kmVec2Fill(&c.start, -(width_ / 2.0) * 0.9, 0.0f); 
-    kmVec2Fill(&c.dir, 0, height_ / 2.0f);
-    
-    kmVec2RotateBy(&c.start, &c.start, rotation, &KM_VEC2_ZERO);
-    c.start.x += x_; c.start.y += y_;
-    kmVec2RotateBy(&c.dir, &c.dir, rotation, &KM_VEC2_ZERO);
-    
-    kmRay2& d = rays_['D'];
-    kmVec2Fill(&d.start, (width_ / 2.0) * 0.9, 0.0f); 
-    kmVec2Fill(&d.dir, 0, height_ / 2.0f);
-    
-    kmVec2RotateBy(&d.start, &d.start, rotation, &KM_VEC2_ZERO);
-    d.start.x += x_; d.start.y += y_;
-    kmVec2RotateBy(&d.dir, &d.dir, rotation, &KM_VEC2_ZERO);
+    for(kmVec2& point: local_body_) {
+        kmVec2RotateBy(&point, &point, degrees_, &KM_VEC2_ZERO);
+    }
 
-    kmRay2& e = rays_['E'];
-    kmVec2Fill(&e.start, 0, 0);
-    kmVec2Fill(&e.dir, 0, -(height_ / 2.0));
+    translate();
+}
+
+void RayBox::translate() {
+    for(uint32_t i = 0; i < SENSOR_MAX; ++i) {
+        const kmRay2& local = template_->rays[i];
+        rays_[i].start.x = local.start.x + x_;
+        rays_[i].start.y = local.start.y + y_;
+        rays_[i].dir = local.dir;
+    }
+
+    for(uint32_t i = 0; i < 4; ++i) {
+        body_[i].x = local_body_[i].x + x_;
+        body_[i].y = local_body_[i].y + y_;
+    }
+}
+
+AABB RayBox::bounds() const {
+    AABB result;
+    kmVec2Fill(&result.min, x_, y_);
+    kmVec2Fill(&result.max, x_, y_);
+
+    for(const kmRay2& ray: rays_) {
+        kmVec2 end;
+        kmVec2Add(&end, &ray.start, &ray.dir);
 
-    kmVec2RotateBy(&e.start, &e.start, rotation, &KM_VEC2_ZERO);
-    e.start.x += x_; e.start.y += y_;
-    kmVec2RotateBy(&e.dir, &e.dir, rotation, &KM_VEC2_ZERO);
+        result.include(ray.start);
+        result.include(end);
+    }
+
+    return result;
 }
 
 void RayBox::set_rotation(float degrees) {
+    if(degrees == degrees_) {
+        return;
+    }
+
     degrees_ = degrees;
-    
     init();
 }
 
@@ -91,6 +175,12 @@ void RayBox::set_position(float x, float y) {
     x_ = x;
     y_ = y;
     
+    translate();
+}
+
+void RayBox::set_body_size(float width, float height) {
+    body_width_ = width;
+    body_height_ = height;
     init();
 }
 
@@ -99,3 +189,39 @@ void RayBox::set_size(float width, float height) {
     height_ = height;
     init();
 }
+
+void RayBox::clear_hits() {
+    for(SensorHit& hit: hits_) {
+        hit.found = false;
+    }
+}
+
+void RayBox::record_hit(Sensor sensor, const kmVec2& point, const kmVec2& normal, const SurfaceAngle& angle) {
+    SensorHit& hit = hits_[sensor];
+
+    float distance = kmVec2DistanceBetween(&point, &rays_[sensor].start);
+    if(hit.found && hit.distance <= distance) {
+        return;
+    }
+
+    hit.found = true;
+    hit.distance = distance;
+    hit.point = point;
+    hit.normal = normal;
+    hit.angle = angle;
+}
+
+/*
+ * For contacts that didn't come through the narrowphase, e.g. ones built by
+ * hand. They're expected to have the ray box as object_a, but the sensors
+ * are matched by name only so that contacts built for the same ray box in
+ * another quadrant still apply. Their surfaces have no precomputed angle, so
+ * it's worked out from the normal.
+ */
+void RayBox::record_hits(const std::vector<Collision>& collisions) {
+    for(const Collision& c: collisions) {
+        if(c.a_ray) {
+            record_hit(sensor_from_name(c.a_ray), c.point, c.b_normal, SurfaceAngle::from_normal(c.b_normal));
+        }
+    }
+}
@@ -1,7 +1,7 @@
 #ifndef RAYBOX_H
 #define RAYBOX_H
 
-#include <map>
+#include <memory>
 
 #include "kazmath/ray2.h"
 #include "collision_primitive.h"
@@ -31,6 +31,43 @@
     
 */
 
+enum Sensor {
+    SENSOR_A = 0,
+    SENSOR_B,
+    SENSOR_C,
+    SENSOR_D,
+    SENSOR_E,
+    SENSOR_L,
+    SENSOR_R,
+    SENSOR_MAX
+};
+
+const char SENSOR_NAMES[SENSOR_MAX] = { 'A', 'B', 'C', 'D', 'E', 'L', 'R' };
+
+/*
+ * The sensors of a ray box at the origin, for one size and rotation. These are
+ * shared between every ray box of that shape, so the trig is only done once
+ * and moving a ray box is just an addition per sensor.
+ */
+struct SensorTemplate {
+    kmRay2 rays[SENSOR_MAX];
+
+    static std::shared_ptr<const SensorTemplate> get(float width, float height, float degrees);
+};
+
+/*
+ * The closest thing a sensor has hit since the hits were last cleared. The
+ * narrowphase keeps these up to date as it goes, so responding to a sensor
+ * doesn't mean searching every contact for it.
+ */
+struct SensorHit {
+    bool found = false;
+    float distance = 0.0f; //From the start of the sensor
+    kmVec2 point;
+    kmVec2 normal; //Of the surface that was hit
+    SurfaceAngle angle; //Also of the surface, carried over from the geometry where it was precomputed
+};
+
 class RayBox : public CollisionPrimitive {
 public:
     typedef std::shared_ptr<RayBox> ptr;
@@ -38,14 +75,31 @@ public:
     RayBox(Object* owner, float width, float height);   
     kmRay2& ray(char which);
     const kmRay2& ray(char which) const;
+
+    kmRay2& sensor(Sensor which) { return rays_[which]; }
+    const kmRay2& sensor(Sensor which) const { return rays_[which]; }
     
     void set_position(float x, float y);
     void set_rotation(float degrees);
+    AABB bounds() const;
     
     float height() const { return height_; }
     float width() const { return width_; }
     
     void set_size(float width, float height);
+
+    /*
+     * The solid part of the ray box that other ray boxes' sensors hit, this is
+     * the size of the character rather than the reach of the sensors. It
+     * defaults to the full size of the ray box.
+     */
+    void set_body_size(float width, float height);
+    const kmVec2& body_point(uint32_t i) const { return body_[i]; }
+
+    void clear_hits();
+    void record_hit(Sensor sensor, const kmVec2& point, const kmVec2& normal, const SurfaceAngle& angle);
+    void record_hits(const std::vector<Collision>& collisions);
+    const SensorHit& nearest_hit(Sensor sensor) const { return hits_[sensor]; }
 private:
     float x_;
     float y_;
@@ -53,9 +107,17 @@ private:
     float height_;
     float degrees_;
     
-    std::map<char, kmRay2> rays_;    
+    std::shared_ptr<const SensorTemplate> template_;
+    kmRay2 rays_[SENSOR_MAX];
+    SensorHit hits_[SENSOR_MAX];
+
+    float body_width_;
+    float body_height_;
+    kmVec2 local_body_[4];
+    kmVec2 body_[4];
     
     void init();
+    void translate();
 };
 
 #endif
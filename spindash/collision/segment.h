@@ -0,0 +1,71 @@
+#ifndef SEGMENT_H
+#define SEGMENT_H
+
+#include <cmath>
+
+#include "collision_primitive.h"
+#include "../typedefs.h"
+
+/**
+    A one-sided surface between two points.
+
+    Sensors only ever care about the surface they hit, so level geometry can be
+    described by its outline rather than by filled triangles. The surface faces
+    to the left going from the first point to the second (so a floor runs left
+    to right) and is only solid from that side, anything behind it passes
+    straight through.
+
+    The normal and angle are worked out once when the points are set. The angle
+    is in degrees clockwise from straight up, which is also kept as a byte (256
+    steps to a full turn) like the angle of a tile in the original games.
+*/
+
+class Segment : public CollisionPrimitive {
+public:
+    Segment():
+        CollisionPrimitive(nullptr) {}
+
+    const kmVec2& point(const uint32_t i) const { return points_[i]; }
+    const kmVec2* points() const { return points_; }
+
+    void set_points(const kmVec2& start, const kmVec2& end) {
+        points_[0] = start;
+        points_[1] = end;
+
+        kmVec2 along;
+        kmVec2Subtract(&along, &end, &start);
+        kmVec2Fill(&normals_[0], -along.y, along.x);
+        kmVec2Normalize(&normals_[0], &normals_[0]);
+        kmVec2Scale(&normals_[1], &normals_[0], -1);
+
+        angle_ = SurfaceAngle::from_normal(normals_[0]);
+        angle_byte_ = uint8_t(int32_t(std::floor((angle_.degrees / 360.0f) * 256.0f + 0.5f)) & 0xFF);
+    }
+
+    ///The direction the surface faces
+    const kmVec2& normal() const { return normals_[0]; }
+
+    ///The normal, then its reverse, so the segment can be treated as a (very thin) polygon
+    const kmVec2* normals() const { return normals_; }
+
+    float angle() const { return angle_.degrees; }
+    const SurfaceAngle& surface_angle() const { return angle_; }
+    uint8_t angle_byte() const { return angle_byte_; }
+
+    void set_position(float x, float y) {} //Segments are absolute
+    void set_rotation(float degrees) {}
+    AABB bounds() const { return AABB::from_points(points_, 2); }
+
+    void set_geometry_handle(SDGeometryHandle handle) { handle_ = handle; }
+    SDGeometryHandle geometry_handle() const { return handle_; }
+
+private:
+    SDGeometryHandle handle_ = 0;
+    kmVec2 points_[2];
+    kmVec2 normals_[2];
+
+    SurfaceAngle angle_;
+    uint8_t angle_byte_ = 0;
+};
+
+#endif // SEGMENT_H
@@ -0,0 +1,119 @@
+#include <cmath>
+#include <algorithm>
+
+#include "spatial_grid.h"
+
+//Anything covering more cells than this goes in the oversized list instead
+const int64_t MAX_CELLS_PER_ITEM = 256;
+
+int32_t SpatialGrid::cell_coordinate(float value) const {
+    return int32_t(std::floor(value / cell_size_));
+}
+
+void SpatialGrid::clear() {
+    cells_.clear();
+    bounds_.clear();
+    oversized_.clear();
+}
+
+void SpatialGrid::insert(uint32_t index, const AABB& bounds) {
+    if(index >= bounds_.size()) {
+        bounds_.resize(index + 1);
+    }
+    bounds_[index] = bounds;
+
+    int32_t min_x = cell_coordinate(bounds.min.x);
+    int32_t min_y = cell_coordinate(bounds.min.y);
+    int32_t max_x = cell_coordinate(bounds.max.x);
+    int32_t max_y = cell_coordinate(bounds.max.y);
+
+    int64_t cell_count = int64_t(max_x - min_x + 1) * int64_t(max_y - min_y + 1);
+    if(cell_count > MAX_CELLS_PER_ITEM) {
+        oversized_.push_back(index);
+        return;
+    }
+
+    for(int32_t x = min_x; x <= max_x; ++x) {
+        for(int32_t y = min_y; y <= max_y; ++y) {
+            cells_[cell_key(x, y)].push_back(index);
+        }
+    }
+}
+
+void SpatialGrid::remove(uint32_t index) {
+    const AABB& bounds = bounds_[index];
+
+    int32_t min_x = cell_coordinate(bounds.min.x);
+    int32_t min_y = cell_coordinate(bounds.min.y);
+    int32_t max_x = cell_coordinate(bounds.max.x);
+    int32_t max_y = cell_coordinate(bounds.max.y);
+
+    int64_t cell_count = int64_t(max_x - min_x + 1) * int64_t(max_y - min_y + 1);
+    if(cell_count > MAX_CELLS_PER_ITEM) {
+        oversized_.erase(std::remove(oversized_.begin(), oversized_.end(), index), oversized_.end());
+        return;
+    }
+
+    for(int32_t x = min_x; x <= max_x; ++x) {
+        for(int32_t y = min_y; y <= max_y; ++y) {
+            auto it = cells_.find(cell_key(x, y));
+            if(it == cells_.end()) {
+                continue;
+            }
+
+            std::vector<uint32_t>& cell = it->second;
+            cell.erase(std::remove(cell.begin(), cell.end(), index), cell.end());
+
+            //Queries compare the area against the number of cells in use, so don't keep empty ones
+            if(cell.empty()) {
+                cells_.erase(it);
+            }
+        }
+    }
+}
+
+void SpatialGrid::query(const AABB& area, std::vector<uint32_t>& indexes) const {
+    indexes.clear();
+
+    int32_t min_x = cell_coordinate(area.min.x);
+    int32_t min_y = cell_coordinate(area.min.y);
+    int32_t max_x = cell_coordinate(area.max.x);
+    int32_t max_y = cell_coordinate(area.max.y);
+
+    int64_t cell_count = int64_t(max_x - min_x + 1) * int64_t(max_y - min_y + 1);
+    if(cell_count > int64_t(cells_.size())) {
+        //The area covers more cells than are in use, so just check all of them
+        for(auto& cell: cells_) {
+            for(uint32_t index: cell.second) {
+                if(bounds_[index].overlaps(area)) {
+                    indexes.push_back(index);
+                }
+            }
+        }
+    } else {
+        for(int32_t x = min_x; x <= max_x; ++x) {
+            for(int32_t y = min_y; y <= max_y; ++y) {
+                auto it = cells_.find(cell_key(x, y));
+                if(it == cells_.end()) {
+                    continue;
+                }
+
+                for(uint32_t index: it->second) {
+                    if(bounds_[index].overlaps(area)) {
+                        indexes.push_back(index);
+                    }
+                }
+            }
+        }
+    }
+
+    for(uint32_t index: oversized_) {
+        if(bounds_[index].overlaps(area)) {
+            indexes.push_back(index);
+        }
+    }
+
+    //Items covering several cells are found more than once
+    std::sort(indexes.begin(), indexes.end());
+    indexes.erase(std::unique(indexes.begin(), indexes.end()), indexes.end());
+}
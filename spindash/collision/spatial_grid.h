@@ -0,0 +1,50 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <vector>
+#include <unordered_map>
+
+#include "collision_primitive.h"
+
+/**
+    A uniform grid over static geometry.
+
+    Items are inserted with an index (their position in the world's list of
+    triangles or boxes) and their bounds, and are stored in every cell that
+    they cover. query then returns the indexes of everything whose bounds
+    overlap an area, in ascending order, so callers test geometry in the same
+    order as they would if they looped over all of it.
+
+    Items that would cover too many cells (huge floors, mostly) aren't stored
+    in cells at all, they're returned by every query that touches them.
+
+    Items can be removed again, and moved by removing and inserting them, so
+    the grid can also hold things that only move now and then.
+*/
+
+class SpatialGrid {
+public:
+    SpatialGrid(float cell_size):
+        cell_size_(cell_size) {}
+
+    void clear();
+    void insert(uint32_t index, const AABB& bounds);
+    void remove(uint32_t index); //The index must have been inserted
+    void query(const AABB& area, std::vector<uint32_t>& indexes) const;
+
+    float cell_size() const { return cell_size_; }
+
+private:
+    float cell_size_;
+
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells_;
+    std::vector<AABB> bounds_; //By index
+    std::vector<uint32_t> oversized_;
+
+    int32_t cell_coordinate(float value) const;
+    static uint64_t cell_key(int32_t x, int32_t y) {
+        return (uint64_t(uint32_t(x)) << 32) | uint32_t(y);
+    }
+};
+
+#endif // SPATIAL_GRID_H
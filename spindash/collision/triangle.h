@@ -12,9 +12,23 @@ public:
     const kmVec2& point(const uint32_t i) { return points_[i]; }
 
     kmVec2* points() { return points_; }
+    const kmVec2* points() const { return points_; }
+
+    void set_points(const kmVec2& v1, const kmVec2& v2, const kmVec2& v3) {
+        points_[0] = v1;
+        points_[1] = v2;
+        points_[2] = v3;
+        calculate_edge_normals(points_, 3, normals_);
+        calculate_edge_angles(normals_, 3, angles_);
+    }
+
+    ///Outward normal of the edge from point(i) to point(i + 1)
+    const kmVec2* normals() const { return normals_; }
+    const SurfaceAngle* angles() const { return angles_; }
 
     void set_position(float x, float y) {} //Triangles are absolute
     void set_rotation(float degrees) {}
+    AABB bounds() const { return AABB::from_points(points_, 3); }
 
     void set_geometry_handle(SDGeometryHandle handle) { handle_ = handle; }
     SDGeometryHandle geometry_handle() const { return handle_; }
@@ -22,6 +36,8 @@ public:
 private:
     SDGeometryHandle handle_ = 0;
     kmVec2 points_[3];
+    kmVec2 normals_[3] = {}; //Left empty if the points are written directly
+    SurfaceAngle angles_[3];
 };
 
 #endif
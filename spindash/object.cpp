@@ -2,13 +2,8 @@
 #include "object.h"
 #include "world.h"
 
-static SDuint generate_id() {
-    static SDuint id = 0;    
-    return ++id;
-}
-
 Object::Object(World* world):
-    id_(generate_id()),
+    id_(world ? world->register_object(this) : 0), //Objects outside of a world can't be looked up
     world_(world),
     rotation_(0.0f) {
     
@@ -16,14 +11,18 @@ Object::Object(World* world):
     kmVec2Fill(&velocity_, 0.0f, 0.0f);
     kmVec2Fill(&acceleration_, 0.0f, 0.0f);
     kmVec2Assign(&last_safe_position_, &position_);
-
-    World::all_objects()[id()] = this; //Register this object globally
+    kmVec2Assign(&previous_position_, &position_);
 }
 
 Object::~Object() {
 
 }
 
+void Object::move_to_clone(World* world) {
+    world_ = world;
+    id_ = world->clone_object_id(id_);
+}
+
 void Object::prepare(float dt) {
     pre_prepare(dt);
 
@@ -39,9 +38,16 @@ void Object::update(float dt) {
     pre_update(dt);
 
     if(!is_fixed_) {
+        kmVec2 motion = velocity_;
+
+        if(world_) {
+            //Stop short of anything we would otherwise pass straight through
+            kmVec2Scale(&motion, &motion, world_->time_of_impact(*this, motion));
+        }
+
         set_position(
-            position().x + velocity_.x,
-            position().y + velocity_.y
+            position().x + motion.x,
+            position().y + motion.y
         );
     }
 
@@ -49,17 +55,19 @@ void Object::update(float dt) {
 }
 
 Object* Object::get(SDuint object_id) {
-    auto it = World::all_objects().find(object_id);
-    
-    if(it == World::all_objects().end()) {
+    World* world = World::get(world_of_object(object_id));
+    Object* object = (world) ? world->find_object(object_id) : nullptr;
+
+    if(!object) {
         throw std::logic_error("Invalid object");
     }
     
-    return (*it).second;
+    return object;
 }
 
 bool Object::exists(SDuint object_id) {
-    return World::all_objects().find(object_id) != World::all_objects().end();
+    World* world = World::get(world_of_object(object_id));
+    return world && world->find_object(object_id);
 }
 
 void Object::set_position(kmScalar x, kmScalar y) {    
@@ -67,6 +75,10 @@ void Object::set_position(kmScalar x, kmScalar y) {
     position_.y = y;
     
     geom().set_position(x, y);
+
+    if(world_) {
+        world_->object_moved(*this);
+    }
 }
 
 void Object::set_rotation(kmScalar angle) {
@@ -74,6 +86,10 @@ void Object::set_rotation(kmScalar angle) {
 	
     rotation_ = angle;
     geom().set_rotation(angle);
+
+    if(world_) {
+        world_->object_moved(*this);
+    }
 }
 
 void Object::set_velocity(kmScalar x, kmScalar y) {
@@ -81,6 +97,8 @@ void Object::set_velocity(kmScalar x, kmScalar y) {
         return;
     }
 
+    wake();
+
     velocity_.x = x;
     velocity_.y = y;
 }
@@ -96,6 +114,45 @@ void Object::set_acceleration(kmScalar x, kmScalar y) {
 
 void Object::set_fixed(kmBool value) {
     is_fixed_ = value;
+
+    if(!is_fixed_) {
+        wake();
+    }
+}
+
+void Object::wake() {
+    still_steps_ = 0;
+
+    if(sleeping_) {
+        sleeping_ = false;
+        frozen_state_changed();
+    }
+}
+
+void Object::update_sleep_state(float velocity_threshold, uint32_t steps) {
+    if(!can_sleep() || kmVec2Length(&velocity_) > velocity_threshold) {
+        still_steps_ = 0;
+        return;
+    }
+
+    if(++still_steps_ >= steps && !sleeping_) {
+        sleeping_ = true;
+        frozen_state_changed();
+    }
+}
+
+void Object::set_active(bool value) {
+    if(active_ != value) {
+        active_ = value;
+        frozen_state_changed();
+    }
+}
+
+void Object::frozen_state_changed() {
+    //The world keeps frozen objects apart from the ones it steps, see World::update_resting_object
+    if(world_) {
+        world_->update_resting_object(*this);
+    }
 }
 
 
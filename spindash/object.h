@@ -11,6 +11,8 @@
 
 typedef uint32_t ObjectID;
 
+const uint32_t MAX_SWEEP_ORIGINS = 3; //How many rays an object's movement can be swept with
+
 enum CollisionFlag {
     IGNORE_DOWNWARD_COLLISION = 1,
     IGNORE_UPWARD_COLLISION = 2,
@@ -29,9 +31,17 @@ protected:
     kmScalar rotation_;
 
     kmVec2 last_safe_position_;
+    kmVec2 previous_position_;
 
     bool is_fixed_ = false;
 
+    bool sleeping_ = false;
+    uint32_t still_steps_ = 0; //How many steps in a row we've been moving slowly enough to sleep
+
+    bool active_ = true; //False when outside all of the world's activation regions
+
+    SDuint type_ = 0; //Game defined, picks the collision response rules. Zero is untyped
+
 private:
     World* world_;       
     
@@ -46,6 +56,8 @@ private:
 
     SDGeometryHandle handle_ = 0;
 
+    void frozen_state_changed();
+
 protected:
     //============== NEW STUFF =============
 
@@ -53,6 +65,19 @@ protected:
         shape_ = shape;
     }
 
+    /*
+     * For clone(). Moves a copy of an object into another world, keeping its
+     * index, and copies one of its shapes for the new object to own.
+     */
+    void move_to_clone(World* world);
+
+    template<typename Shape>
+    CollisionPrimitive::ptr clone_shape(const CollisionPrimitive& shape) {
+        CollisionPrimitive::ptr copy(new Shape(static_cast<const Shape&>(shape)));
+        copy->set_owner(this);
+        return copy;
+    }
+
     //======================================
 public:
     typedef std::tr1::shared_ptr<Object> ptr;
@@ -60,10 +85,11 @@ public:
     Object(World* world);
     virtual ~Object();
 
-    static void register_object(Object* obj);
-    static void unregister_object(Object* obj);
     static Object* get(SDuint object_id);
     static bool exists(SDuint object_id);
+
+    ///A copy of this object for a clone of its world, see World::clone
+    virtual ptr clone(World* world) const = 0;
     
     void store_safe_position() {
         kmVec2Assign(&last_safe_position_, &position_);
@@ -71,12 +97,44 @@ public:
     void revert_to_safe_position() {
         kmVec2Assign(&position_, &last_safe_position_);
     }
+
+    void store_previous_position() {
+        kmVec2Assign(&previous_position_, &position_);
+    }
+
+    ///Blends between the position before the last step (alpha = 0) and the current one (alpha = 1)
+    kmVec2 interpolated_position(float alpha) const {
+        kmVec2 result;
+        result.x = previous_position_.x + (position_.x - previous_position_.x) * alpha;
+        result.y = previous_position_.y + (position_.y - previous_position_.y) * alpha;
+        return result;
+    }
     
     void set_position(kmScalar x, kmScalar y);
     virtual void set_velocity(kmScalar x, kmScalar y);
     void set_acceleration(kmScalar x, kmScalar y);
     virtual void set_rotation(kmScalar degrees);
     void set_fixed(kmBool value);
+    bool is_fixed() const { return is_fixed_; }
+
+    bool is_sleeping() const { return sleeping_; }
+    void wake();
+    void update_sleep_state(float velocity_threshold, uint32_t steps);
+
+    bool is_active() const { return active_; }
+    void set_active(bool value);
+
+    ///Sleeping objects, and those outside the activation regions, are frozen in place
+    bool is_frozen() const { return sleeping_ || !active_; }
+
+    ///Subclasses can return false here to stay awake even when they aren't moving
+    virtual bool can_sleep() const { return true; }
+
+    void set_type(SDuint type) { type_ = type; }
+    SDuint type() const { return type_; }
+
+    ///Triggers only report overlaps, they don't move or collide with anything
+    virtual bool is_trigger() const { return false; }
 
     const kmVec2& position() const { return position_; }
     const kmVec2& velocity() const { return velocity_; }
@@ -88,6 +146,21 @@ public:
     virtual void update(float dt);
     virtual void update_finished(float dt) {}    
     virtual bool respond_to(const std::vector<Collision>& collisions) { return true; }
+
+    /*
+     * Objects that can move fast enough to skip over geometry return how far
+     * their leading edge is from their position along the (unit) direction of
+     * movement, and their movement is swept against the static geometry before
+     * the sensors are tested. Zero (the default) disables the swept test.
+     *
+     * The sweep casts a ray from each of the sweep origins, which is just the
+     * object's position unless it has parts that stick out on their own.
+     */
+    virtual float sweep_extent(const kmVec2& direction) const { return 0.0f; }
+    virtual uint32_t sweep_origins(kmVec2* origins) const {
+        origins[0] = position();
+        return 1;
+    }
     
     SDuint id() const { return id_; }
     
@@ -0,0 +1,81 @@
+#include "rigid_object.h"
+#include "world.h"
+
+void RigidObject::pre_prepare(float dt) {
+    if(gravity_enabled_ && world() && !is_fixed()) {
+        kmVec2 grv = world()->gravity();
+        kmVec2Scale(&grv, &grv, dt);
+        kmVec2Add(&velocity_, &velocity_, &grv);
+    }
+}
+
+bool RigidObject::respond_to(const std::vector<Collision>& collisions) {
+    /*
+     *  Stops moving into anything we're touching, and pushes out of the deepest
+     *  overlap. Overlaps shallower than RESTING_CONTACT_DEPTH are left alone so
+     *  that a resting object stays in contact (and can go to sleep) rather than
+     *  bouncing off the surface every step. Ray hits have no depth, those come
+     *  from characters which do their own response.
+     *
+     *  Between two loose objects the one on top does all of the work, otherwise
+     *  the one underneath is pushed into whatever is supporting it and the
+     *  stack sinks. Objects side by side share the correction.
+     */
+
+    kmVec2 down = { 0, -1 };
+    if(world()) {
+        down = world()->gravity();
+        if(kmVec2LengthSq(&down) > 0) {
+            kmVec2Normalize(&down, &down);
+        }
+    }
+
+    float best_correction = 0.0f;
+    kmVec2 best_normal = { 0, 0 };
+
+    for(const Collision& c: collisions) {
+        if(c.depth <= 0.0f) {
+            continue;
+        }
+
+        //The normal of the other shape's surface, which points away from it and towards us
+        kmVec2 normal = (c.object_a == &geom()) ? c.b_normal : c.a_normal;
+
+        float share = 1.0f;
+
+        Collision copy = c;
+        RigidObject* other = dynamic_cast<RigidObject*>(get_other_object_from_collision(copy));
+        if(other && !other->is_fixed() && !other->is_frozen()) {
+            float alignment = kmVec2Dot(&normal, &down);
+            if(alignment > 0.5f) {
+                continue; //It's on top of us, it'll move itself
+            } else if(alignment > -0.5f) {
+                share = 0.5f;
+            }
+        }
+
+        float into = kmVec2Dot(&velocity_, &normal);
+        if(into < 0) {
+            kmVec2 cancel;
+            kmVec2Scale(&cancel, &normal, into);
+            kmVec2Subtract(&velocity_, &velocity_, &cancel);
+        }
+
+        float correction = (c.depth - RESTING_CONTACT_DEPTH) * share;
+        if(correction > best_correction) {
+            best_correction = correction;
+            best_normal = normal;
+        }
+    }
+
+    if(best_correction <= 0.0f) {
+        return false;
+    }
+
+    set_position(
+        position().x + best_normal.x * best_correction,
+        position().y + best_normal.y * best_correction
+    );
+
+    return true;
+}
@@ -0,0 +1,26 @@
+#ifndef RIGID_OBJECT_H
+#define RIGID_OBJECT_H
+
+#include "object.h"
+
+/*
+ * Base for simple solid objects (boxes and circles) that can optionally fall
+ * under gravity, and that respond to overlaps by pushing themselves out
+ */
+class RigidObject : public Object {
+public:
+    RigidObject(World* world):
+        Object(world) {}
+
+    void set_gravity_enabled(bool value) { gravity_enabled_ = value; }
+    bool gravity_enabled() const { return gravity_enabled_; }
+
+    bool respond_to(const std::vector<Collision>& collisions);
+
+private:
+    bool gravity_enabled_ = false;
+
+    void pre_prepare(float dt);
+};
+
+#endif // RIGID_OBJECT_H
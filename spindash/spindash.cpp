@@ -2,6 +2,8 @@
 #include "spindash.h"
 #include "character.h"
 #include "world.h"
+#include "box_object.h"
+#include "circle_object.h"
 
 void sdCharacterLeftPressed(SDuint character) {
     Character* c = Character::get(character);
@@ -63,6 +65,27 @@ SDfloat sdCharacterGetGroundSpeed(SDuint character) {
     return c->ground_speed();
 }
 
+/**
+ * \brief Switches a character to one of the built-in sets of movement constants
+ */
+void sdCharacterSetProfilePreset(SDuint character, SDProfilePreset preset) {
+    Character* c = Character::get(character);
+    c->set_profile(profile_preset(preset));
+}
+
+/**
+ * \brief Sets a character's movement constants, this is cheap enough to do every step
+ */
+void sdCharacterSetProfile(SDuint character, const SDCharacterProfile* profile) {
+    Character* c = Character::get(character);
+    c->set_profile(*profile);
+}
+
+void sdCharacterGetProfile(SDuint character, SDCharacterProfile* out) {
+    Character* c = Character::get(character);
+    *out = c->profile();
+}
+
 void sdCharacterEnableSkill(SDuint character, sdSkill skill) {
     Character* c = Character::get(character);
     c->enable_skill(skill);
@@ -100,6 +123,8 @@ void sdObjectDestroy(SDuint entity) {
 void sdObjectSetPosition(SDuint object, SDfloat x, SDfloat y) {
     Object* obj = Object::get(object);
     obj->set_position(x, y);
+    obj->store_previous_position(); //Don't interpolate across a teleport
+    obj->wake();
 }
 
 void sdObjectGetPosition(SDuint object, SDfloat* x, SDfloat* y) {
@@ -146,6 +171,21 @@ void sdObjectSetFixed(SDuint object, SDbool value) {
     obj->set_fixed(value);
 }
 
+SDbool sdObjectIsSleeping(SDuint object) {
+    Object* obj = Object::get(object);
+    return obj->is_sleeping();
+}
+
+void sdObjectWake(SDuint object) {
+    Object* obj = Object::get(object);
+    obj->wake();
+}
+
+SDbool sdObjectIsActive(SDuint object) {
+    Object* obj = Object::get(object);
+    return obj->is_active();
+}
+
 SDfloat sdObjectGetRotation(SDuint object) {
     Object* obj = Object::get(object);
     return obj->rotation();
@@ -156,6 +196,40 @@ SDuint sdBoxCreate(SDuint world_id, SDfloat width, SDfloat height) {
     return world->new_box(width, height);
 }
 
+/**
+ * \brief Makes a box fall under the world's gravity, so it can be pushed around and stacked
+ */
+void sdBoxSetGravityEnabled(SDuint box, SDbool value) {
+    BoxObject* b = BoxObject::get(box);
+    b->set_gravity_enabled(value);
+}
+
+/**
+ * \brief Creates a circle, these are much cheaper to collide than boxes so use them for rings, bumpers and projectiles
+ */
+SDuint sdCircleCreate(SDuint world_id, SDfloat diameter) {
+    World* world = World::get(world_id);
+    return world->new_circle(diameter);
+}
+
+/**
+ * \brief Makes a circle fall under the world's gravity, like sdBoxSetGravityEnabled
+ */
+void sdCircleSetGravityEnabled(SDuint circle, SDbool value) {
+    CircleObject* c = CircleObject::get(circle);
+    c->set_gravity_enabled(value);
+}
+
+/**
+ * \brief Creates a trigger volume, which reports what overlaps it through sdWorldGetTriggerEvents
+ *
+ * Triggers don't collide with anything or move on their own, place them with sdObjectSetPosition.
+ */
+SDuint sdTriggerCreate(SDuint world_id, SDfloat width, SDfloat height) {
+    World* world = World::get(world_id);
+    return world->new_trigger(width, height);
+}
+
 SDuint sdSpringCreate(SDuint world_id, SDfloat angle, SDfloat power) {
     World* world = World::get(world_id);
     return world->new_spring(power, angle);
@@ -172,6 +246,36 @@ SDuint sdWorldCreate() {
     return World::create();
 }
 
+/**
+ * \brief Creates a copy of a world to step ahead and throw away
+ *
+ * The copy carries on from exactly where the world is, but the two
+ * don't affect each other afterwards. The static geometry is shared
+ * until either world changes it, so cloning only costs a copy of the
+ * objects. Returns the ID of the new world, which must be destroyed
+ * with sdWorldDestroy like any other. The world must not be stepping
+ * on another thread while it's cloned.
+ */
+SDuint sdWorldClone(SDuint world) {
+    return World::clone(world);
+}
+
+/**
+ * \brief Finds the copy of an object in a clone of its world
+ *
+ * Returns zero if the clone has no such object (e.g. it was destroyed
+ * in the clone).
+ */
+SDuint sdWorldGetClonedObject(SDuint clone_id, SDuint object) {
+    World* clone = World::get(clone_id);
+    if(!clone) {
+        return 0;
+    }
+
+    ObjectID cloned = clone->clone_object_id(object);
+    return (clone->find_object(cloned)) ? cloned : 0;
+}
+
 /** \brief Destroys a world
  *
  * \param world - The world to destroy
@@ -213,6 +317,43 @@ void sdWorldAddMesh(SDuint world_id, SDuint num_triangles, kmVec2* points) {
     }
 }
 
+/**
+ * \brief Adds a one-sided surface from points[0] to points[1]
+ *
+ * The surface faces left going from the first point to the second, so a floor
+ * runs from left to right, and it's only solid from the side it faces.
+ */
+void sdWorldAddSegment(SDuint world_id, kmVec2* points) {
+    World* world = World::get(world_id);
+    world->add_segment(points[0], points[1]);
+}
+
+/**
+ * \brief Like sdWorldAddMesh, but only adds the outline of the mesh as surfaces
+ *
+ * Sensors only ever hit the outside of level geometry, so this is much cheaper
+ * to collide with than the filled triangles. Edges between two triangles are
+ * dropped and straight runs of edges become a single surface.
+ */
+void sdWorldAddMeshSurfaces(SDuint world_id, SDuint num_triangles, kmVec2* points) {
+    World* world = World::get(world_id);
+    world->add_mesh_surfaces(points, num_triangles);
+}
+
+/**
+ * \brief Reduces the number of triangles and boxes in the world without changing its shape
+ *
+ * Call this once the level geometry has been added. Vertices closer together
+ * than weld_tolerance are joined, and neighbouring pieces are merged into
+ * bigger triangles and boxes wherever that keeps the same outline, so flat
+ * runs of tiles become a few long surfaces. Changed pieces are compiled again
+ * if there is a compile callback. Returns how many pieces were removed.
+ */
+SDuint sdWorldCompactGeometry(SDuint world_id, SDfloat weld_tolerance) {
+    World* world = World::get(world_id);
+    return world->compact_geometry(weld_tolerance);
+}
+
 void sdWorldRemoveTriangles(SDuint world_id) {
     World* world = World::get(world_id);
     assert(world);
@@ -226,7 +367,183 @@ void sdWorldStep(SDuint world_id, SDfloat dt) {
         return;
     }
 
-    world->update(dt);
+    world->step(dt);
+}
+
+/**
+ * \brief Switches the world to fixed time stepping
+ *
+ * \param step - The length of each update, zero goes back to variable stepping
+ * \param max_sub_steps - The most updates a single sdWorldStep will run
+ *
+ * sdWorldStep will accumulate the time it is given and run updates of exactly
+ * step seconds. Time left over is reported by sdWorldGetInterpolationAlpha so
+ * renderers can draw between the last two updates.
+ */
+void sdWorldSetFixedTimeStep(SDuint world_id, SDfloat step, SDuint max_sub_steps) {
+    World* world = World::get(world_id);
+    world->set_fixed_step(step, max_sub_steps);
+}
+
+SDfloat sdWorldGetInterpolationAlpha(SDuint world_id) {
+    World* world = World::get(world_id);
+    return world->interpolation_alpha();
+}
+
+/**
+ * \brief Fills objects and positions with the interpolated position of every object
+ *
+ * Returns the number of objects written, which is at most capacity.
+ */
+SDuint sdWorldGetInterpolatedPositions(SDuint world_id, SDuint* objects, SDVec2* positions, SDuint capacity) {
+    World* world = World::get(world_id);
+    return world->get_interpolated_positions(objects, positions, capacity);
+}
+
+/**
+ * \brief Fills out with the position, speed and rotation of every object in the world
+ *
+ * Returns the number of states written, which is at most capacity. This is
+ * much cheaper than calling the sdObjectGet* functions for each object.
+ */
+SDuint sdWorldGetObjectStates(SDuint world_id, SDObjectState* out, SDuint capacity) {
+    World* world = World::get(world_id);
+    return world->get_object_states(out, capacity);
+}
+
+/**
+ * \brief Like sdWorldGetObjectStates, but fills in character specific state for every character
+ */
+SDuint sdWorldGetCharacterStates(SDuint world_id, SDCharacterState* out, SDuint capacity) {
+    World* world = World::get(world_id);
+    return world->get_character_states(out, capacity);
+}
+
+/**
+ * \brief Returns how many trigger events the last sdWorldStep generated
+ */
+SDuint sdWorldGetTriggerEventCount(SDuint world_id) {
+    World* world = World::get(world_id);
+    return world->trigger_event_count();
+}
+
+/**
+ * \brief Fills out with the trigger enter, stay and exit events from the last sdWorldStep
+ *
+ * Returns the number of events written, which is at most capacity. The events
+ * from each update are sorted by trigger, then by object.
+ */
+SDuint sdWorldGetTriggerEvents(SDuint world_id, SDTriggerEvent* out, SDuint capacity) {
+    World* world = World::get(world_id);
+    return world->get_trigger_events(out, capacity);
+}
+
+/**
+ * \brief Applies the buttons held by many characters for the next step in one call
+ *
+ * Each frame names a character in this world and a mask of SDInputButton values,
+ * which is the same as calling the matching sdCharacter*Pressed functions.
+ * Recording the frames submitted before each sdWorldStep is enough to replay a run.
+ */
+void sdWorldSubmitInputs(SDuint world_id, const SDInputFrame* frames, SDuint count) {
+    World* world = World::get(world_id);
+    world->submit_inputs(frames, count);
+}
+
+/**
+ * \brief Queues inputs to be applied at the start of the next update
+ *
+ * Unlike sdWorldSubmitInputs this is safe to call from one other thread while
+ * the world is updating. Returns the number of frames queued, which is less than
+ * count if the queue filled up.
+ */
+SDuint sdWorldQueueInputs(SDuint world_id, const SDInputFrame* frames, SDuint count) {
+    World* world = World::get(world_id);
+
+    SDuint queued = 0;
+    for(; queued < count; ++queued) {
+        WorldCommand command = {};
+        command.type = WorldCommand::INPUT;
+        command.object = frames[queued].character;
+        command.buttons = frames[queued].buttons;
+
+        if(!world->queue_command(command)) {
+            break;
+        }
+    }
+
+    return queued;
+}
+
+/**
+ * \brief Queues a teleport to be applied at the start of the next update
+ */
+SDbool sdWorldQueueObjectPosition(SDuint world_id, SDuint object, SDfloat x, SDfloat y) {
+    World* world = World::get(world_id);
+
+    WorldCommand command = {};
+    command.type = WorldCommand::SET_POSITION;
+    command.object = object;
+    command.value.x = x;
+    command.value.y = y;
+    return world->queue_command(command);
+}
+
+/**
+ * \brief Queues a change of speed to be applied at the start of the next update
+ */
+SDbool sdWorldQueueObjectSpeed(SDuint world_id, SDuint object, SDfloat x, SDfloat y) {
+    World* world = World::get(world_id);
+
+    WorldCommand command = {};
+    command.type = WorldCommand::SET_SPEED;
+    command.object = object;
+    command.value.x = x;
+    command.value.y = y;
+    return world->queue_command(command);
+}
+
+/**
+ * \brief Publishes a snapshot of every object and character at the end of each update
+ */
+void sdWorldEnableStatePublishing(SDuint world_id) {
+    World* world = World::get(world_id);
+    world->enable_publishing();
+}
+
+void sdWorldDisableStatePublishing(SDuint world_id) {
+    World* world = World::get(world_id);
+    world->disable_publishing();
+}
+
+/**
+ * \brief Switches to the latest published snapshot, and returns the step it was taken at
+ *
+ * The snapshot stays the same until this is called again, so the published
+ * object and character states always come from the same step.
+ */
+SDuint64 sdWorldAcquirePublishedState(SDuint world_id) {
+    World* world = World::get(world_id);
+    world->acquire_published_state();
+    return world->published_state().step;
+}
+
+SDuint sdWorldGetPublishedObjectStates(SDuint world_id, SDObjectState* out, SDuint capacity) {
+    World* world = World::get(world_id);
+    const std::vector<SDObjectState>& states = world->published_state().objects;
+
+    SDuint count = std::min<SDuint>(capacity, states.size());
+    std::copy(states.begin(), states.begin() + count, out);
+    return count;
+}
+
+SDuint sdWorldGetPublishedCharacterStates(SDuint world_id, SDCharacterState* out, SDuint capacity) {
+    World* world = World::get(world_id);
+    const std::vector<SDCharacterState>& states = world->published_state().characters;
+
+    SDuint count = std::min<SDuint>(capacity, states.size());
+    std::copy(states.begin(), states.begin() + count, out);
+    return count;
 }
 
 SDuint64 sdWorldGetStepCounter(SDuint world_id) {
@@ -234,6 +551,67 @@ SDuint64 sdWorldGetStepCounter(SDuint world_id) {
     return world->step_counter();
 }
 
+/**
+ * \brief Fills out with how many collision tries object updates have needed since the last reset
+ *
+ * out[n] is the number of object updates that settled after n + 1 tries, and
+ * the entry after those counts updates that never settled. Returns the number
+ * of entries written, there are at most 11.
+ */
+SDuint sdWorldGetCollisionTriesHistogram(SDuint world_id, SDuint64* out, SDuint capacity) {
+    World* world = World::get(world_id);
+    const std::vector<uint64_t>& histogram = world->tries_histogram();
+
+    SDuint count = std::min<SDuint>(capacity, histogram.size());
+    std::copy(histogram.begin(), histogram.begin() + count, out);
+    return count;
+}
+
+void sdWorldResetCollisionTriesHistogram(SDuint world_id) {
+    World* world = World::get(world_id);
+    world->reset_tries_histogram();
+}
+
+/**
+ * \brief Casts a ray against the static geometry and objects in the world
+ *
+ * Fills in hit with the nearest surface along the ray, if there is one, and
+ * returns whether anything was hit. The object with the ignore ID is skipped,
+ * pass the object that is doing the looking (or 0) so it doesn't hit itself.
+ * Triggers are never hit.
+ */
+SDbool sdWorldRayCast(SDuint world_id, const SDRay* ray, SDuint ignore, SDRayHit* hit) {
+    World* world = World::get(world_id);
+    return world->ray_cast(ray, 1, ignore, hit) > 0;
+}
+
+/**
+ * \brief Like sdWorldRayCast, for count rays at once
+ *
+ * Fills in one hit for each ray and returns how many of them hit something.
+ * Neighbouring rays that go the same way are cast together, so this is much
+ * cheaper than casting them one at a time.
+ */
+SDuint sdWorldRayCastBatch(SDuint world_id, const SDRay* rays, SDuint count, SDuint ignore, SDRayHit* hits) {
+    World* world = World::get(world_id);
+    return world->ray_cast(rays, count, ignore, hits);
+}
+
+/**
+ * \brief Finds the static geometry and objects whose bounds overlap the box from min to max
+ *
+ * The triangles, boxes and segments come first, then the objects. Returns the
+ * number of hits written, which is at most capacity.
+ */
+SDuint sdWorldQueryAABB(SDuint world_id, const SDVec2* min, const SDVec2* max, SDQueryHit* out, SDuint capacity) {
+    World* world = World::get(world_id);
+
+    AABB area;
+    area.min = *min;
+    area.max = *max;
+    return world->query(area, out, capacity);
+}
+
 /**
  * Mainly for testing, constructs a loop out of triangles
  */
@@ -336,6 +714,28 @@ SDbool sdWorldDebugIsEnabled(SDuint world_id) {
     return world->debug_mode_enabled();
 }
 
+/**
+ * \brief Lets objects that stop moving go to sleep
+ *
+ * An object that moves slower than the velocity threshold for a number of
+ * steps in a row (see sdWorldSetSleepParameters) is put to sleep, and costs
+ * nothing until something moves into it, it is moved or its speed is set.
+ */
+void sdWorldEnableSleeping(SDuint world_id) {
+    World* world = World::get(world_id);
+    world->enable_sleeping();
+}
+
+void sdWorldDisableSleeping(SDuint world_id) {
+    World* world = World::get(world_id);
+    world->disable_sleeping();
+}
+
+void sdWorldSetSleepParameters(SDuint world_id, SDfloat velocity_threshold, SDuint steps) {
+    World* world = World::get(world_id);
+    world->set_sleep_parameters(velocity_threshold, steps);
+}
+
 void sdWorldCameraTarget(SDuint world_id, SDuint object) {
     World* world = World::get(world_id);
     world->set_camera_target(object);
@@ -348,6 +748,27 @@ void sdWorldCameraGetPosition(SDuint world_id, SDfloat* x, SDfloat* y) {
     *y = pos.y;
 }
 
+/**
+ * \brief Adds a region of the world that is simulated
+ *
+ * \param anchor - The object the region is centred on, or zero for the camera
+ * \param half_width - Half the width of the region
+ * \param half_height - Half the height of the region
+ *
+ * Once a world has activation regions, objects outside all of them are frozen
+ * until they are back inside one. The camera target is always simulated. For
+ * split-screen, add a region for each player.
+ */
+void sdWorldAddActivationRegion(SDuint world_id, SDuint anchor, SDfloat half_width, SDfloat half_height) {
+    World* world = World::get(world_id);
+    world->add_activation_region(anchor, half_width, half_height);
+}
+
+void sdWorldClearActivationRegions(SDuint world_id) {
+    World* world = World::get(world_id);
+    world->clear_activation_regions();
+}
+
 void sdWorldSetObjectCollisionCallback(SDuint world_id, ObjectCollisionCallback callback, void* user_data) {
     /*
      * Sets the callback which is called when a collision is detected between two objects.
@@ -361,3 +782,84 @@ void sdWorldSetObjectCollisionCallback(SDuint world_id, ObjectCollisionCallback
     InternalObjectCollisionCallback cb = std::bind(callback, _1, _2, _3, _4, user_data);
     world->set_object_collision_callback(cb);
 }
+
+/**
+ * \brief Records object collisions for sdWorldGetCollisionEvents instead of calling the collision callback
+ *
+ * While enabled the step never calls out, responses for each pair come from
+ * sdWorldSetCollisionResponse and anything not set there gets the default response.
+ */
+void sdWorldEnableCollisionEvents(SDuint world_id) {
+    World* world = World::get(world_id);
+    world->enable_collision_events();
+}
+
+void sdWorldDisableCollisionEvents(SDuint world_id) {
+    World* world = World::get(world_id);
+    world->disable_collision_events();
+}
+
+/**
+ * \brief Returns how many object collisions were recorded during the last sdWorldStep
+ */
+SDuint sdWorldGetCollisionEventCount(SDuint world_id) {
+    World* world = World::get(world_id);
+    return world->collision_event_count();
+}
+
+/**
+ * \brief Fills out with the object collisions from the last sdWorldStep, returns the number written
+ */
+SDuint sdWorldGetCollisionEvents(SDuint world_id, SDCollisionEvent* out, SDuint capacity) {
+    World* world = World::get(world_id);
+    return world->get_collision_events(out, capacity);
+}
+
+/**
+ * \brief Sets the responses used whenever these two objects collide, without asking the collision callback
+ */
+void sdWorldSetCollisionResponse(SDuint world_id, SDuint lhs, SDuint rhs, CollisionResponse lhs_response, CollisionResponse rhs_response) {
+    World* world = World::get(world_id);
+    world->set_collision_response(lhs, rhs, lhs_response, rhs_response);
+}
+
+void sdWorldClearCollisionResponses(SDuint world_id) {
+    World* world = World::get(world_id);
+    world->clear_collision_responses();
+}
+
+/**
+ * \brief Tags an object with a game defined type (from 1 up to 31) for sdWorldSetTypeResponse, zero removes the type
+ */
+void sdObjectSetType(SDuint object, SDuint type) {
+    Object* obj = Object::get(object);
+    obj->set_type(type);
+}
+
+SDuint sdObjectGetType(SDuint object) {
+    Object* obj = Object::get(object);
+    return obj->type();
+}
+
+/**
+ * \brief Sets the response for objects of type colliding with objects of other_type
+ *
+ * This is used for any pair that doesn't have a response set with sdWorldSetCollisionResponse,
+ * and is checked before the collision callback. If launch_speed is greater than zero the object
+ * is launched at that speed, at launch_angle degrees clockwise from straight up, instead of
+ * the response's usual launch.
+ */
+void sdWorldSetTypeResponse(SDuint world_id, SDuint type, SDuint other_type, CollisionResponse response, SDfloat launch_speed, SDfloat launch_angle) {
+    World* world = World::get(world_id);
+
+    ResponseRule rule;
+    rule.response = response;
+    rule.launch_speed = launch_speed;
+    rule.launch_angle = launch_angle;
+    world->set_type_response(type, other_type, rule);
+}
+
+void sdWorldClearTypeResponses(SDuint world_id) {
+    World* world = World::get(world_id);
+    world->clear_type_responses();
+}
@@ -17,15 +17,42 @@ enum sdSkill {
 };
 
 SDuint sdWorldCreate();
+SDuint sdWorldClone(SDuint world);
+SDuint sdWorldGetClonedObject(SDuint clone, SDuint object);
 void sdWorldAddTriangle(SDuint world, kmVec2* points);
 void sdWorldAddBox(SDuint world, kmVec2* points);
 void sdWorldAddMesh(SDuint world, SDuint num_triangles, kmVec2* points);
+void sdWorldAddSegment(SDuint world, kmVec2* points);
+void sdWorldAddMeshSurfaces(SDuint world, SDuint num_triangles, kmVec2* points);
 void sdWorldConstructLoop(SDuint world, SDfloat left, SDfloat top,
     SDfloat width);
+SDuint sdWorldCompactGeometry(SDuint world, SDfloat weld_tolerance);
 void sdWorldRemoveTriangles(SDuint world);
 void sdWorldStep(SDuint world, SDfloat dt);
+void sdWorldSetFixedTimeStep(SDuint world, SDfloat step, SDuint max_sub_steps);
+SDfloat sdWorldGetInterpolationAlpha(SDuint world);
+SDuint sdWorldGetInterpolatedPositions(SDuint world, SDuint* objects, SDVec2* positions, SDuint capacity);
+SDuint sdWorldGetObjectStates(SDuint world, SDObjectState* out, SDuint capacity);
+SDuint sdWorldGetCharacterStates(SDuint world, SDCharacterState* out, SDuint capacity);
+SDuint sdWorldGetTriggerEventCount(SDuint world);
+SDuint sdWorldGetTriggerEvents(SDuint world, SDTriggerEvent* out, SDuint capacity);
+void sdWorldSubmitInputs(SDuint world, const SDInputFrame* frames, SDuint count);
+
+SDuint sdWorldQueueInputs(SDuint world, const SDInputFrame* frames, SDuint count);
+SDbool sdWorldQueueObjectPosition(SDuint world, SDuint object, SDfloat x, SDfloat y);
+SDbool sdWorldQueueObjectSpeed(SDuint world, SDuint object, SDfloat x, SDfloat y);
+void sdWorldEnableStatePublishing(SDuint world);
+void sdWorldDisableStatePublishing(SDuint world);
+SDuint64 sdWorldAcquirePublishedState(SDuint world);
+SDuint sdWorldGetPublishedObjectStates(SDuint world, SDObjectState* out, SDuint capacity);
+SDuint sdWorldGetPublishedCharacterStates(SDuint world, SDCharacterState* out, SDuint capacity);
 void sdWorldDestroy(SDuint world);
 SDuint64 sdWorldGetStepCounter(SDuint world);
+SDuint sdWorldGetCollisionTriesHistogram(SDuint world, SDuint64* out, SDuint capacity);
+void sdWorldResetCollisionTriesHistogram(SDuint world);
+SDbool sdWorldRayCast(SDuint world, const SDRay* ray, SDuint ignore, SDRayHit* hit);
+SDuint sdWorldRayCastBatch(SDuint world, const SDRay* rays, SDuint count, SDuint ignore, SDRayHit* hits);
+SDuint sdWorldQueryAABB(SDuint world, const SDVec2* min, const SDVec2* max, SDQueryHit* hits, SDuint capacity);
 void sdWorldSetCompileGeometryCallback(SDuint world_id, SDCompileGeometryCallback callback, void* userData);
 void sdWorldSetRenderGeometryCallback(SDuint world_id, SDRenderGeometryCallback callback, void* userData);
 void sdWorldRender(SDuint world_id);
@@ -34,9 +61,16 @@ void sdWorldDebugStep(SDuint world, SDfloat step);
 SDbool sdWorldDebugIsEnabled(SDuint world);
 void sdWorldDebugDisable(SDuint world);
 
+void sdWorldEnableSleeping(SDuint world);
+void sdWorldDisableSleeping(SDuint world);
+void sdWorldSetSleepParameters(SDuint world, SDfloat velocity_threshold, SDuint steps);
+
 void sdWorldCameraTarget(SDuint world, SDuint object);
 void sdWorldCameraGetPosition(SDuint world, SDfloat* x, SDfloat* y);
 
+void sdWorldAddActivationRegion(SDuint world, SDuint anchor, SDfloat half_width, SDfloat half_height);
+void sdWorldClearActivationRegions(SDuint world);
+
 void sdObjectDestroy(SDuint object);
 void sdObjectSetPosition(SDuint object, SDfloat x, SDfloat y);
 void sdObjectGetPosition(SDuint object, SDfloat *x, SDfloat *y);
@@ -48,12 +82,18 @@ void sdObjectSetSpeedX(SDuint object, SDfloat x);
 void sdObjectSetSpeedY(SDuint object, SDfloat y);
 SDfloat sdObjectGetRotation(SDuint object);
 void sdObjectSetFixed(SDuint object, SDbool value); //Make object unmoveable
+SDbool sdObjectIsSleeping(SDuint object);
+void sdObjectWake(SDuint object);
+SDbool sdObjectIsActive(SDuint object);
 
 void sdObjectSetBounciness(SDuint object, SDfloat v);
 void sdObjectSetFriction(SDuint object, SDfloat friction);
 
 SDuint sdCharacterCreate(SDuint world);
 void sdCharacterOverrideSetting(const char* setting, float value);
+void sdCharacterSetProfilePreset(SDuint character, SDProfilePreset preset);
+void sdCharacterSetProfile(SDuint character, const SDCharacterProfile* profile);
+void sdCharacterGetProfile(SDuint character, SDCharacterProfile* out);
 
 SDbool sdCharacterIsGrounded(SDuint character);
 SDbool sdCharacterIsJumping(SDuint character);
@@ -83,7 +123,10 @@ SDbool sdObjectIsCharacter(SDuint object);
 SDuint sdSpringCreate(SDuint world, SDfloat angle, SDfloat power);
 
 SDuint sdBoxCreate(SDuint world, SDfloat width, SDfloat height);
+void sdBoxSetGravityEnabled(SDuint box, SDbool value);
 SDuint sdCircleCreate(SDuint world, SDfloat diameter);
+void sdCircleSetGravityEnabled(SDuint circle, SDbool value);
+SDuint sdTriggerCreate(SDuint world, SDfloat width, SDfloat height);
 
 enum CollisionResponse {
     COLLISION_RESPONSE_NONE,  //Collision is ignored
@@ -109,6 +152,29 @@ enum CollisionResponse {
 typedef void (*ObjectCollisionCallback)(SDuint, SDuint, CollisionResponse*, CollisionResponse*, void* data);
 void sdWorldSetObjectCollisionCallback(SDuint world, ObjectCollisionCallback callback, void* user_data);
 
+/*
+ * A collision between two objects during the last sdWorldStep, the normal is
+ * the surface normal of lhs, pointing towards rhs
+ */
+typedef struct SDCollisionEvent {
+    SDuint lhs;
+    SDuint rhs;
+    SDVec2 point;
+    SDVec2 normal;
+} SDCollisionEvent;
+
+void sdWorldEnableCollisionEvents(SDuint world);
+void sdWorldDisableCollisionEvents(SDuint world);
+SDuint sdWorldGetCollisionEventCount(SDuint world);
+SDuint sdWorldGetCollisionEvents(SDuint world, SDCollisionEvent* out, SDuint capacity);
+void sdWorldSetCollisionResponse(SDuint world, SDuint lhs, SDuint rhs, CollisionResponse lhs_response, CollisionResponse rhs_response);
+void sdWorldClearCollisionResponses(SDuint world);
+
+void sdObjectSetType(SDuint object, SDuint type);
+SDuint sdObjectGetType(SDuint object);
+void sdWorldSetTypeResponse(SDuint world, SDuint type, SDuint other_type, CollisionResponse response, SDfloat launch_speed, SDfloat launch_angle);
+void sdWorldClearTypeResponses(SDuint world);
+
 #ifdef __cplusplus
 }
 #endif
@@ -5,10 +5,18 @@
 
 bool Spring::respond_to(const std::vector<Collision>& collisions) {
     
-    if(collisions.empty()) return false;
-    
     //FIXME: search for collisions where the angle of the normal matches angle
-    Object* other = (collisions[0].object_a == &geom()) ? collisions[0].object_b->owner() : collisions[0].object_a->owner();    
+    Object* other = nullptr;
+    for(const Collision& c: collisions) {
+        //Skip the level geometry, which doesn't have an owner
+        CollisionPrimitive* primitive = (c.object_a == &geom()) ? c.object_b : c.object_a;
+        if(primitive && primitive->owner()) {
+            other = primitive->owner();
+            break;
+        }
+    }
+
+    if(!other) return false;
     
     sdObjectSetSpeedX(other->id(), sinf(kmDegreesToRadians(angle_)) * power_);
     sdObjectSetSpeedY(other->id(), cosf(kmDegreesToRadians(angle_)) * power_);
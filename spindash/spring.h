@@ -18,6 +18,13 @@ public:
     }
     
     bool respond_to(const std::vector<Collision>& collisions);
+
+    Object::ptr clone(World* world) const {
+        Spring* copy = new Spring(*this);
+        copy->move_to_clone(world);
+        copy->set_geom(copy->clone_shape<Box>(geom()));
+        return Object::ptr(copy);
+    }
     
 private:
     float power_;
@@ -0,0 +1,64 @@
+#ifndef SD_SPSC_QUEUE_H
+#define SD_SPSC_QUEUE_H
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+/*
+ * A bounded, lock-free queue for exactly one producer thread and one consumer
+ * thread. push() never blocks, it just fails when the queue is full.
+ */
+template<typename T>
+class SPSCQueue {
+public:
+    SPSCQueue(std::size_t capacity):
+        slots_(capacity + 1) {} //One slot is always left empty to tell full from empty
+
+    bool push(const T& value) {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t next = increment(tail);
+        if(next == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        slots_[tail] = value;
+        tail_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& out) {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        if(head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        out = slots_[head];
+        head_.store(increment(head), std::memory_order_release);
+        return true;
+    }
+
+    std::size_t capacity() const { return slots_.size() - 1; }
+
+private:
+    std::size_t increment(std::size_t i) const {
+        return (i + 1 == slots_.size()) ? 0 : i + 1;
+    }
+
+    std::vector<T> slots_;
+
+    /*
+     * Padded out onto separate cache lines so the two threads don't fight
+     * over them. This is done with padding rather than alignas, as over-aligned
+     * types can't safely be new'd in C++11 and the queue lives inside World.
+     */
+    static const std::size_t CACHE_LINE_SIZE = 64;
+
+    char head_padding_[CACHE_LINE_SIZE];
+    std::atomic<std::size_t> head_{0};
+    char tail_padding_[CACHE_LINE_SIZE - sizeof(std::atomic<std::size_t>)];
+    std::atomic<std::size_t> tail_{0};
+    char end_padding_[CACHE_LINE_SIZE - sizeof(std::atomic<std::size_t>)];
+};
+
+#endif // SD_SPSC_QUEUE_H
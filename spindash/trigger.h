@@ -0,0 +1,30 @@
+#ifndef SD_TRIGGER_H
+#define SD_TRIGGER_H
+
+#include "object.h"
+#include "collision/box.h"
+
+/*
+ * A volume that reports the objects overlapping it. Triggers are only tested
+ * against the bounds of other objects, and never go through the narrowphase or
+ * the response loop, so they're cheap enough for every ring and checkpoint.
+ */
+class Trigger : public Object {
+public:
+    Trigger(World* world, float width, float height):
+        Object(world) {
+
+        set_geom(CollisionPrimitive::ptr(new Box(this, width, height)));
+    }
+
+    bool is_trigger() const { return true; }
+
+    Object::ptr clone(World* world) const {
+        Trigger* copy = new Trigger(*this);
+        copy->move_to_clone(world);
+        copy->set_geom(copy->clone_shape<Box>(geom()));
+        return Object::ptr(copy);
+    }
+};
+
+#endif // SD_TRIGGER_H
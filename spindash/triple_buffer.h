@@ -0,0 +1,45 @@
+#ifndef SD_TRIPLE_BUFFER_H
+#define SD_TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+/*
+ * Hands the latest complete value from one writer thread to one reader thread
+ * without either of them waiting. The writer fills back() and calls publish(),
+ * the reader calls acquire() and then reads front() for as long as it likes.
+ */
+template<typename T>
+class TripleBuffer {
+public:
+    T& back() { return buffers_[back_]; }
+    const T& front() const { return buffers_[front_]; }
+
+    void publish() {
+        uint8_t previous = middle_.exchange(back_ | FRESH_BIT, std::memory_order_acq_rel);
+        back_ = previous & INDEX_MASK;
+    }
+
+    /* Swaps in the most recently published value, returns false if there wasn't a new one */
+    bool acquire() {
+        if(!(middle_.load(std::memory_order_relaxed) & FRESH_BIT)) {
+            return false;
+        }
+
+        uint8_t previous = middle_.exchange(front_, std::memory_order_acq_rel);
+        front_ = previous & INDEX_MASK;
+        return true;
+    }
+
+private:
+    static const uint8_t FRESH_BIT = 4;
+    static const uint8_t INDEX_MASK = 3;
+
+    T buffers_[3];
+
+    uint8_t back_ = 0; //Only touched by the writer
+    uint8_t front_ = 1; //Only touched by the reader
+    std::atomic<uint8_t> middle_{2};
+};
+
+#endif // SD_TRIPLE_BUFFER_H
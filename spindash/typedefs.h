@@ -50,4 +50,119 @@ typedef enum SDAnimationState {
     ANIMATION_STATE_PUSHING
 } SDAnimationState;
 
+/*
+ * The movement constants for a character, in world units and seconds. Fill
+ * one in from a preset with sdCharacterGetProfile to tune individual values.
+ */
+typedef struct SDCharacterProfile {
+    SDfloat acceleration;
+    SDfloat deceleration;
+    SDfloat friction;
+    SDfloat top_speed;
+    SDfloat top_y_speed;
+    SDfloat slope;
+    SDfloat initial_jump;
+    SDfloat jump_cut_off;
+    SDfloat air_drag_rate;
+    SDfloat air_drag_min_x_speed;
+    SDfloat air_drag_max_y_speed;
+} SDCharacterProfile;
+
+typedef enum SDProfilePreset {
+    SD_PROFILE_SONIC,
+    SD_PROFILE_TAILS,
+    SD_PROFILE_KNUCKLES,
+    SD_PROFILE_UNDERWATER,
+    SD_PROFILE_SUPER
+} SDProfilePreset;
+
+typedef enum SDInputButton {
+    SD_INPUT_LEFT = 1,
+    SD_INPUT_RIGHT = 2,
+    SD_INPUT_UP = 4,
+    SD_INPUT_DOWN = 8,
+    SD_INPUT_JUMP = 16
+} SDInputButton;
+
+/*
+ * The buttons held by a character for the next step, as a mask of
+ * SDInputButton values. An array of these per step is a complete
+ * record of the input, so they double as the replay format.
+ */
+typedef struct SDInputFrame {
+    SDuint character;
+    SDuint buttons;
+} SDInputFrame;
+
+/*
+ * Snapshots of object and character state, filled in bulk by
+ * sdWorldGetObjectStates and sdWorldGetCharacterStates
+ */
+
+typedef struct SDObjectState {
+    SDuint object;
+    SDVec2 position;
+    SDVec2 speed;
+    SDfloat rotation;
+} SDObjectState;
+
+typedef struct SDCharacterState {
+    SDuint character;
+    SDAnimationState animation_state;
+    SDDirection facing;
+    SDbool grounded;
+    SDfloat ground_speed;
+    SDfloat spindash_charge;
+} SDCharacterState;
+
+/*
+ * Objects entering, staying inside and leaving trigger volumes during the
+ * last sdWorldStep, read back with sdWorldGetTriggerEvents
+ */
+
+typedef enum SDTriggerEventType {
+    SD_TRIGGER_ENTER,
+    SD_TRIGGER_STAY,
+    SD_TRIGGER_EXIT
+} SDTriggerEventType;
+
+typedef struct SDTriggerEvent {
+    SDuint trigger;
+    SDuint object;
+    SDTriggerEventType type;
+} SDTriggerEvent;
+
+/*
+ * What a ray cast or sdWorldQueryAABB found, static geometry is identified by
+ * its index in the world's list of triangles, boxes or segments
+ */
+
+typedef enum SDQueryHitType {
+    SD_QUERY_HIT_OBJECT,
+    SD_QUERY_HIT_TRIANGLE,
+    SD_QUERY_HIT_BOX,
+    SD_QUERY_HIT_SEGMENT
+} SDQueryHitType;
+
+/*
+ * Ray casts against the world for sdWorldRayCast and sdWorldRayCastBatch, a
+ * ray covers start to start + dir
+ */
+
+typedef kmRay2 SDRay;
+
+typedef struct SDRayHit {
+    SDbool hit;
+    SDQueryHitType type;
+    SDuint id; //The object ID, or the index of the geometry
+    SDVec2 point;
+    SDVec2 normal; //Of the surface that was hit
+    SDfloat fraction; //How far along dir the hit is, from 0 to 1
+} SDRayHit;
+
+typedef struct SDQueryHit {
+    SDQueryHitType type;
+    SDuint id; //The object ID, or the index of the geometry
+} SDQueryHit;
+
 #endif
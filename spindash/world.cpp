@@ -1,28 +1,35 @@
 #include <iostream>
+#include <cmath>
+#include <stdexcept>
 #include <cassert>
 #include <map>
 #include <functional>
 #include <algorithm>
 #include <tr1/functional>
 #include <tr1/memory>
+#include <mutex>
+#include <limits>
 
 #include "kazbase/logging.h"
 #include "collision/collide.h"
+#include "collision/compact.h"
 #include "kazmath/vec2.h"
+#include "kazmath/ray2.h"
 #include "world.h"
 
 #include "character.h"
 #include "spring.h"
 #include "box_object.h"
+#include "circle_object.h"
+#include "trigger.h"
 
 #include "spindash.h"
 
 const kmVec2 GRAVITY_IN_MPS = { 0, (-0.21875 / 40.0) * 60.0};
 
-SDuint World::world_id_counter_ = 0;
-
 World::World(SDuint id):
     id_(id),
+    geometry_(new StaticGeometry),
 	step_counter_(0),
 	step_mode_enabled_(false) {
     set_gravity(0.0f, GRAVITY_IN_MPS.y);
@@ -48,24 +55,31 @@ void World::render() {
     translation.x = 0;
     translation.y = 0;
 
-    for(const Triangle& triangle: triangles_) {
+    for(const Triangle& triangle: geometry_->triangles) {
         auto handle = triangle.geometry_handle();
         if(handle) {
             render_callback_->callback(handle, &translation, angle, render_callback_->user_data);
         }
     }
 
-    for(const Box& box: boxes_) {
+    for(const Box& box: geometry_->boxes) {
         auto handle = box.geometry_handle();
         if(handle) {
             render_callback_->callback(handle, &translation, angle, render_callback_->user_data);
         }
     }
 
+    for(const Segment& segment: geometry_->segments) {
+        auto handle = segment.geometry_handle();
+        if(handle) {
+            render_callback_->callback(handle, &translation, angle, render_callback_->user_data);
+        }
+    }
+
     for(const auto& object: objects_) {
         auto handle = object->geometry_handle();
         if(handle) {
-            auto trans = object->position();
+            auto trans = object->interpolated_position(interpolation_alpha_);
             render_callback_->callback(handle, &trans, angle, render_callback_->user_data);
         }
     }
@@ -93,26 +107,26 @@ void World::debug_render() {
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     glPushMatrix();
         glBegin(GL_TRIANGLES);
-        for(unsigned int i = 0; i < triangles_.size(); ++i) {
+        for(unsigned int i = 0; i < geometry_->triangles.size(); ++i) {
             float* colour = colours[colour_counter];
             (colour_counter >= 9) ? colour_counter = 0: colour_counter++;
 
             glColor3f(colour[0], colour[1], colour[2]);
 
             for(unsigned int j = 0; j < 3; ++j) {
-                glVertex2f(triangles_[i].points[j].x, triangles_[i].points[j].y);
+                glVertex2f(geometry_->triangles[i].points[j].x, geometry_->triangles[i].points[j].y);
             }
         }
         glEnd();
         glBegin(GL_QUADS);
-        for(unsigned int i = 0; i < boxes_.size(); ++i) {
+        for(unsigned int i = 0; i < geometry_->boxes.size(); ++i) {
             float* colour = colours[colour_counter];
             (colour_counter >= 9) ? colour_counter = 0: colour_counter++;
 
             glColor3f(colour[0], colour[1], colour[2]);
 
             for(unsigned int j = 0; j < 4; ++j) {
-                glVertex2f(boxes_[i].point(j).x, boxes_[i].point(j).y);
+                glVertex2f(geometry_->boxes[i].point(j).x, geometry_->boxes[i].point(j).y);
             }
         }        
         glEnd();
@@ -158,62 +172,307 @@ void World::debug_render() {
 }*/
 
 
-void World::handle_collision_response(Object& obj, Object& other, CollisionResponse response_type, const std::vector<Collision>& collisions) {
-    switch(response_type) {
-    case COLLISION_RESPONSE_NONE: return;
-    case COLLISION_RESPONSE_DEFAULT: return; //Handled elsewhere
-    case COLLISION_RESPONSE_SPRING_LOW:
-    case COLLISION_RESPONSE_SPRING_HIGH:
-    case COLLISION_RESPONSE_SPRINGBOARD_LOW:
-    case COLLISION_RESPONSE_SPRINGBOARD_HIGH:
-    case COLLISION_RESPONSE_BALLOON: {
-        float x = obj.velocity().x;
-        float y = 7.0 / 40.0;
-        obj.set_velocity(x, y);
-    } break;
-    case COLLISION_RESPONSE_BUMPER: {
-
-    }
-    case COLLISION_RESPONSE_SPRING_CAP: {
-
-    } break;
-    case COLLISION_RESPONSE_BOUNCE_ONE: {
-        float x = obj.velocity().x;
-        float y = 6.5 / 40.0;
-        obj.set_velocity(x, y);
-    } break;
-    case COLLISION_RESPONSE_BOUNCE_TWO: {
-        float x = obj.velocity().x;
-        float y = 7.5 / 40.0;
-        obj.set_velocity(x, y);
-    } break;
-    case COLLISION_RESPONSE_BOUNCE_THREE: {
-        float x = obj.velocity().x;
-        float y = 8.5 / 40.0;
-        obj.set_velocity(x, y);
-    } break;
-    case COLLISION_RESPONSE_BREAKABLE_OBJECT: {
-        float x = obj.velocity().x;
-        float y = 3.0 / 40.0;
-        obj.set_velocity(x, y);
-    } break;
-    case COLLISION_RESPONSE_REBOUND:
-    case COLLISION_RESPONSE_HAZARD: {
-        float x = float(sgn(obj.position().x - other.position().x)) / 40.0;
-        float y = 4.0 / 40.0;
-        obj.set_velocity(x, y);
-    } break;
-    case COLLISION_RESPONSE_DEATH: {
-        float x = 0;
-        float y = 7.0 / 40.0;
-        obj.set_velocity(x, y);
-    } break;
-    case COLLISION_RESPONSE_POWER_UP:
-    case COLLISION_RESPONSE_UNFIX:
-        break;
+namespace {
+
+/*
+ * How each built-in response launches the object, indexed by CollisionResponse.
+ * Responses that don't launch anything have no y speed.
+ */
+struct LaunchDefaults {
+    bool keep_x; //Keep the horizontal speed, otherwise it's set to away_x
+    float away_x; //Horizontal speed away from the other object
+    float y;
+};
+
+const LaunchDefaults LAUNCH_DEFAULTS[] = {
+    { true, 0, 0 }, //COLLISION_RESPONSE_NONE
+    { true, 0, 0 }, //COLLISION_RESPONSE_DEFAULT, handled elsewhere
+    { true, 0, 7.0 / 40.0 }, //COLLISION_RESPONSE_SPRING_LOW
+    { true, 0, 7.0 / 40.0 }, //COLLISION_RESPONSE_SPRING_HIGH
+    { true, 0, 7.0 / 40.0 }, //COLLISION_RESPONSE_SPRINGBOARD_LOW
+    { true, 0, 7.0 / 40.0 }, //COLLISION_RESPONSE_SPRINGBOARD_HIGH
+    { true, 0, 7.0 / 40.0 }, //COLLISION_RESPONSE_BALLOON
+    { true, 0, 0 }, //COLLISION_RESPONSE_BUMPER
+    { true, 0, 0 }, //COLLISION_RESPONSE_SPRING_CAP
+    { true, 0, 6.5 / 40.0 }, //COLLISION_RESPONSE_BOUNCE_ONE
+    { true, 0, 7.5 / 40.0 }, //COLLISION_RESPONSE_BOUNCE_TWO
+    { true, 0, 8.5 / 40.0 }, //COLLISION_RESPONSE_BOUNCE_THREE
+    { true, 0, 3.0 / 40.0 }, //COLLISION_RESPONSE_BREAKABLE_OBJECT
+    { false, 1.0 / 40.0, 4.0 / 40.0 }, //COLLISION_RESPONSE_REBOUND
+    { false, 1.0 / 40.0, 4.0 / 40.0 }, //COLLISION_RESPONSE_HAZARD
+    { false, 0, 7.0 / 40.0 }, //COLLISION_RESPONSE_DEATH
+    { true, 0, 0 }, //COLLISION_RESPONSE_POWER_UP
+    { true, 0, 0 } //COLLISION_RESPONSE_UNFIX
+};
+
+static_assert(
+    sizeof(LAUNCH_DEFAULTS) / sizeof(LaunchDefaults) == COLLISION_RESPONSE_UNFIX + 1,
+    "Every CollisionResponse needs an entry in LAUNCH_DEFAULTS"
+);
+
+}
+
+void World::handle_collision_response(Object& obj, Object& other, const ResponseRule& rule, const std::vector<Collision>& collisions) {
+    if(rule.launch_speed > 0.0f) {
+        //The rule gives its own launch, the angle is clockwise from straight up like springs
+        float angle = kmDegreesToRadians(rule.launch_angle);
+        obj.set_velocity(sinf(angle) * rule.launch_speed, cosf(angle) * rule.launch_speed);
+        return;
+    }
+
+    const LaunchDefaults& launch = LAUNCH_DEFAULTS[rule.response];
+    if(launch.y == 0.0f) {
+        return; //This response doesn't launch anything
+    }
+
+    float x = (launch.keep_x) ? obj.velocity().x : float(sgn(obj.position().x - other.position().x)) * launch.away_x;
+    obj.set_velocity(x, launch.y);
+}
+
+/*
+ * Ray boxes keep the nearest hit of each sensor as they're tested, and that's
+ * all they respond to, so they skip building the contacts.
+ */
+static void collide_with(CollisionPrimitive* geom, RayBox* sensors, CollisionPrimitive* other, std::vector<Collision>& collisions) {
+    if(sensors) {
+        collide_sensors(sensors, other);
+        return;
+    }
+
+    std::vector<Collision> new_collisions = collide(geom, other);
+    if(!new_collisions.empty()) {
+        collisions.insert(collisions.end(), new_collisions.begin(), new_collisions.end());
+    }
+}
+
+static uint64_t collision_response_key(ObjectID lhs, ObjectID rhs) {
+    return (uint64_t(std::min(lhs, rhs)) << 32) | std::max(lhs, rhs);
+}
+
+void World::set_collision_response(ObjectID lhs, ObjectID rhs, CollisionResponse lhs_response, CollisionResponse rhs_response) {
+    if(lhs > rhs) {
+        std::swap(lhs_response, rhs_response);
+    }
+
+    collision_responses_[collision_response_key(lhs, rhs)] = std::make_pair(lhs_response, rhs_response);
+}
+
+void World::set_type_response(SDuint type, SDuint other_type, const ResponseRule& rule) {
+    if(type == 0 || other_type == 0 || type >= MAX_OBJECT_TYPES || other_type >= MAX_OBJECT_TYPES) {
+        throw std::out_of_range("Object types must be between 1 and MAX_OBJECT_TYPES - 1");
+    }
+
+    if(type_responses_.empty()) {
+        type_responses_.resize(MAX_OBJECT_TYPES * MAX_OBJECT_TYPES);
+    }
+
+    ResponseRule& entry = type_responses_[(type * MAX_OBJECT_TYPES) + other_type];
+    entry = rule;
+    entry.is_set = true;
+}
+
+const ResponseRule* World::find_type_response(SDuint type, SDuint other_type) const {
+    if(type_responses_.empty() || type >= MAX_OBJECT_TYPES || other_type >= MAX_OBJECT_TYPES) {
+        return nullptr;
+    }
+
+    const ResponseRule& entry = type_responses_[(type * MAX_OBJECT_TYPES) + other_type];
+    return (entry.is_set) ? &entry : nullptr;
+}
+
+void World::find_collision_responses(Object& lhs, Object& rhs, ResponseRule* lhs_rule, ResponseRule* rhs_rule) {
+    /*
+     *  Responses set for the pair of objects take priority, then the rules for
+     *  their types (each side is looked up on its own). The callback is only
+     *  used when neither table has anything for the pair, and never while
+     *  collision events are enabled, so the step doesn't call out to the user
+     *  at all.
+     */
+
+    auto it = collision_responses_.find(collision_response_key(lhs.id(), rhs.id()));
+    if(it != collision_responses_.end()) {
+        lhs_rule->response = (lhs.id() < rhs.id()) ? it->second.first : it->second.second;
+        rhs_rule->response = (lhs.id() < rhs.id()) ? it->second.second : it->second.first;
+        return;
+    }
+
+    const ResponseRule* lhs_type_rule = find_type_response(lhs.type(), rhs.type());
+    const ResponseRule* rhs_type_rule = find_type_response(rhs.type(), lhs.type());
+    if(lhs_type_rule || rhs_type_rule) {
+        if(lhs_type_rule) *lhs_rule = *lhs_type_rule;
+        if(rhs_type_rule) *rhs_rule = *rhs_type_rule;
+        return;
+    }
+
+    if(object_collision_callback_ && !collision_events_enabled_) {
+        object_collision_callback_(lhs.id(), rhs.id(), &lhs_rule->response, &rhs_rule->response);
+    }
+}
+
+SDuint World::get_collision_events(SDCollisionEvent* events, SDuint capacity) const {
+    SDuint count = std::min<SDuint>(capacity, collision_events_.size());
+    std::copy(collision_events_.begin(), collision_events_.begin() + count, events);
+    return count;
+}
+
+void World::set_fixed_step(double step, uint32_t max_sub_steps) {
+    fixed_step_ = step;
+    max_sub_steps_ = std::max<uint32_t>(1, max_sub_steps);
+    accumulator_ = 0.0;
+    interpolation_alpha_ = 1.0f;
+}
+
+void World::step(double dt) {
+    clear_step_events();
+
+    if(fixed_step_ <= 0.0) {
+        update(dt);
+        return;
+    }
+
+    if(step_mode_enabled_) return;
+
+    accumulator_ += dt;
+
+    uint32_t sub_steps = 0;
+    while(accumulator_ >= fixed_step_ && sub_steps < max_sub_steps_) {
+        update(fixed_step_);
+        accumulator_ -= fixed_step_;
+        ++sub_steps;
+    }
+
+    if(accumulator_ >= fixed_step_) {
+        //We've fallen too far behind, drop the time rather than spiral trying to catch up
+        accumulator_ = std::fmod(accumulator_, fixed_step_);
+    }
+
+    interpolation_alpha_ = float(accumulator_ / fixed_step_);
+}
+
+SDuint World::get_interpolated_positions(SDuint* objects, SDVec2* positions, SDuint capacity) const {
+    SDuint count = std::min<SDuint>(capacity, objects_.size());
+
+    for(SDuint i = 0; i < count; ++i) {
+        const Object& object = *objects_[i];
+        objects[i] = object.id();
+        positions[i] = object.interpolated_position(interpolation_alpha_);
+    }
+
+    return count;
+}
+
+SDuint World::get_object_states(SDObjectState* states, SDuint capacity) const {
+    SDuint count = std::min<SDuint>(capacity, objects_.size());
+
+    for(SDuint i = 0; i < count; ++i) {
+        const Object& object = *objects_[i];
+        SDObjectState& state = states[i];
+
+        state.object = object.id();
+        state.position = object.position();
+        state.speed = object.velocity();
+        state.rotation = object.rotation();
+    }
+
+    return count;
+}
+
+SDuint World::get_character_states(SDCharacterState* states, SDuint capacity) const {
+    SDuint count = std::min<SDuint>(capacity, characters_.size());
+
+    for(SDuint i = 0; i < count; ++i) {
+        const Character& character = *characters_[i];
+        SDCharacterState& state = states[i];
+
+        state.character = character.id();
+        state.animation_state = character.animation_state();
+        state.facing = character.facing();
+        state.grounded = character.ground_state() != GROUND_STATE_IN_THE_AIR;
+        state.ground_speed = character.ground_speed();
+        state.spindash_charge = character.spindash_charge();
+    }
+
+    return count;
+}
+
+Character* World::find_character(SDuint character_id) const {
+    return dynamic_cast<Character*>(find_object(character_id));
+}
+
+void World::submit_inputs(const SDInputFrame* frames, SDuint count) {
+    for(SDuint i = 0; i < count; ++i) {
+        Character* character = find_character(frames[i].character);
+        if(!character) {
+            L_WARN("sdWorldSubmitInputs: No such character in this world");
+            continue;
+        }
+
+        character->apply_input(frames[i].buttons);
+    }
+}
+
+bool World::queue_command(const WorldCommand& command) {
+    return commands_.push(command);
+}
+
+bool World::is_resting_contact(const std::vector<Collision>& collisions) {
+    /*
+     *  Ray hits come from characters, which always count as a disturbance. A
+     *  resting box sinks a little way into whatever it's on each step before
+     *  it's pushed back out, so anything up to twice the resting depth is still
+     *  just something sitting there.
+     */
+    for(const Collision& c: collisions) {
+        if(c.a_ray || c.b_ray || c.depth > RESTING_CONTACT_DEPTH * 2) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void World::apply_queued_commands() {
+    WorldCommand command;
+    while(commands_.pop(command)) {
+        switch(command.type) {
+            case WorldCommand::INPUT: {
+                Character* character = find_character(command.object);
+                if(character) {
+                    character->apply_input(command.buttons);
+                }
+            } break;
+            case WorldCommand::SET_POSITION: {
+                Object* object = find_object(command.object);
+                if(!object) break;
+
+                object->set_position(command.value.x, command.value.y);
+                object->store_previous_position();
+                object->wake();
+            } break;
+            case WorldCommand::SET_SPEED: {
+                Object* object = find_object(command.object);
+                if(!object) break;
+
+                object->set_velocity(command.value.x, command.value.y);
+            } break;
+        }
     }
 }
 
+void World::publish_state() {
+    PublishedState& state = published_.back();
+    state.step = step_counter_;
+
+    //resize() keeps the capacity, so once warmed up this doesn't allocate
+    state.objects.resize(objects_.size());
+    get_object_states(state.objects.data(), state.objects.size());
+
+    state.characters.resize(characters_.size());
+    get_character_states(state.characters.data(), state.characters.size());
+
+    published_.publish();
+}
+
 void World::update(double step, bool override_step_mode) {
 	if(!override_step_mode && step_mode_enabled_) return;
 	
@@ -243,39 +502,97 @@ void World::update(double step, bool override_step_mode) {
                 if collisions:                    
                     lhs.respond_to(collisions.sort_by(distance))
     */                                
-    
+
+    apply_queued_commands();
+    update_activation();
+
+    if(sleeping_enabled_) {
+        refresh_awake_objects();
+        wake_objects_near_movers();
+    }
+
+    //Only awake objects are stepped, waking and sleeping during the step doesn't change that
+    refresh_awake_objects();
+    step_objects_ = awake_objects_;
+
+    //Remember where everything was so renderers can interpolate between steps
+    for(uint32_t i: step_objects_) {
+        objects_[i]->store_previous_position();
+    }
+
     //Call update on each object, this shouldn't change the objects position, but just velocity etc.
-    std::for_each(objects_.begin(), objects_.end(), std::tr1::bind(&Object::prepare, std::tr1::placeholders::_1, step));
+    for(uint32_t i: step_objects_) {
+        objects_[i]->prepare(step);
+    }
 
+    find_object_neighbours();
 
-    for(uint32_t i = 0; i < objects_.size(); ++i) {
+    //Sleeping objects that get hit are woken after the loop, so they don't run half a step
+    std::vector<uint32_t> objects_to_wake;
+
+    /*
+     * When two objects both want the default response, the one processed second
+     * needs to respond to the first too. We remember that here as the pair
+     * test is only run once, by whichever object comes first.
+     */
+    earlier_contacts_.resize(objects_.size());
+    for(uint32_t i: step_objects_) {
+        earlier_contacts_[i].clear();
+    }
+
+    for(uint32_t i: step_objects_) {
         Object& lhs = *objects_.at(i);
+        if(lhs.is_frozen() || lhs.is_trigger()) {
+            continue;
+        }
+
         bool run_loop = true;
 
         lhs.update(step); //Move without responding to collisions
 
         //Now, process any Object vs Object collisions, these don't have to be recursive
 
-        std::vector<uint32_t> objects_to_collide_with;
+        std::vector<uint32_t> objects_to_collide_with = earlier_contacts_[i];
 
-        for(uint32_t j = i + 1; j < objects_.size(); ++j) {
+        for(uint32_t j: find_pair_candidates(i)) {
             Object& rhs = *objects_.at(j);
+            if(rhs.is_trigger()) {
+                continue; //Triggers only look at bounds, that's done after everything has moved
+            }
+
+            //Frozen objects never run this test themselves, so everything else tests against them
+            if(j < i && !rhs.is_frozen()) {
+                continue;
+            }
+
             std::vector<Collision> new_collisions = collide(&lhs.geom(), &rhs.geom());
             if(!new_collisions.empty()) {
-                CollisionResponse cr1 = COLLISION_RESPONSE_DEFAULT;
-                CollisionResponse cr2 = COLLISION_RESPONSE_DEFAULT;
-                if(object_collision_callback_) {
-                    object_collision_callback_(lhs.id(), rhs.id(), &cr1, &cr2);
+                if(rhs.is_sleeping() && !is_resting_contact(new_collisions)) {
+                    objects_to_wake.push_back(j);
+                }
+
+                ResponseRule cr1, cr2;
+                find_collision_responses(lhs, rhs, &cr1, &cr2);
+
+                if(collision_events_enabled_) {
+                    SDCollisionEvent event;
+                    event.lhs = lhs.id();
+                    event.rhs = rhs.id();
+                    event.point = new_collisions[0].point;
+                    event.normal = new_collisions[0].a_normal;
+                    collision_events_.push_back(event);
                 }
 
-                if(cr1 != COLLISION_RESPONSE_DEFAULT) {
+                if(cr1.response != COLLISION_RESPONSE_DEFAULT) {
                     handle_collision_response(lhs, rhs, cr1, new_collisions);
                 } else {
                     objects_to_collide_with.push_back(j);
                 }
 
-                if(cr2 == COLLISION_RESPONSE_DEFAULT) {
-
+                if(cr2.response == COLLISION_RESPONSE_DEFAULT) {
+                    if(j > i && !rhs.is_frozen()) {
+                        earlier_contacts_[j].push_back(i);
+                    }
                 } else {
                     handle_collision_response(rhs, lhs, cr2, new_collisions);
                 }
@@ -284,26 +601,32 @@ void World::update(double step, bool override_step_mode) {
 
         std::vector<Collision> collisions;
 
-        uint32_t tries = 10;
-        while(run_loop && tries--) {
-            //FIXME: We only need to test stuff within a certain radius...
+        uint32_t tries = 0;
+        while(run_loop && tries < MAX_COLLISION_TRIES) {
+            ++tries;
 
-            for(uint32_t j = 0; j < get_triangle_count(); ++j) {
-                Triangle& triangle = triangles_.at(j);
-                
-                std::vector<Collision> new_collisions = collide(&lhs.geom(), &triangle);
-                if(!new_collisions.empty()) {
-                    collisions.insert(collisions.end(), new_collisions.begin(), new_collisions.end());
-                }
+            //Looked up each time, responding can switch the geom (e.g. characters changing quadrant)
+            RayBox* sensors = dynamic_cast<RayBox*>(&lhs.geom());
+            if(sensors) {
+                sensors->clear_hits(); //Drop anything left by other objects testing against us
             }
 
-            for(uint32_t j = 0; j < get_box_count(); ++j) {
-                Box& triangle = boxes_.at(j);
-                
-                std::vector<Collision> new_collisions = collide(&lhs.geom(), &triangle);
-                if(!new_collisions.empty()) {
-                    collisions.insert(collisions.end(), new_collisions.begin(), new_collisions.end());
-                }
+            //Only the static geometry around where we are now can touch us
+            AABB bounds = lhs.geom().bounds();
+
+            geometry_->triangle_grid.query(bounds, nearby_geometry_);
+            for(uint32_t j: nearby_geometry_) {
+                collide_with(&lhs.geom(), sensors, &geometry_->triangles.at(j), collisions);
+            }
+
+            geometry_->box_grid.query(bounds, nearby_geometry_);
+            for(uint32_t j: nearby_geometry_) {
+                collide_with(&lhs.geom(), sensors, &geometry_->boxes.at(j), collisions);
+            }
+
+            geometry_->segment_grid.query(bounds, nearby_geometry_);
+            for(uint32_t j: nearby_geometry_) {
+                collide_with(&lhs.geom(), sensors, &geometry_->segments.at(j), collisions);
             }
 
             //FIXME: this doesn't seem right :/ not sure how to handle object collisions really...
@@ -311,27 +634,44 @@ void World::update(double step, bool override_step_mode) {
             //The problem is that this only works for one side of the collision.. what about when the other side returns
             //that it wants a default response?
             for(uint32_t j: objects_to_collide_with) {
-                Object& rhs = *objects_.at(j);
-                std::vector<Collision> new_collisions = collide(&lhs.geom(), &rhs.geom());
-                if(!new_collisions.empty()) {
-                    collisions.insert(collisions.end(), new_collisions.begin(), new_collisions.end());
-                }
+                collide_with(&lhs.geom(), sensors, &objects_.at(j)->geom(), collisions);
             }
                         
+            kmVec2 before = lhs.position();
             run_loop = lhs.respond_to(collisions);
             collisions.clear();
 
+            //Responses often nudge the position by a tiny amount and ask to go again, only
+            //bother if we actually moved enough to touch something different
+            if(run_loop && kmVec2DistanceBetween(&before, &lhs.position()) < CONVERGENCE_TOLERANCE) {
+                run_loop = false;
+            }
+
             if(debug_mode_enabled()) { 
 				run_loop = false;
 			}
         }
         lhs.update_finished(step);
-        if(!tries) {
+        if(run_loop) {
+            //Still moving after every try, go back to where we were last happy
             lhs.revert_to_safe_position();
+            ++tries_histogram_[MAX_COLLISION_TRIES];
         } else {
             lhs.store_safe_position();
+            ++tries_histogram_[tries - 1];
+        }
+
+        if(sleeping_enabled_) {
+            lhs.update_sleep_state(sleep_velocity_threshold_, sleep_steps_);
         }
     }
+
+    for(uint32_t i: objects_to_wake) {
+        objects_.at(i)->wake();
+    }
+
+    update_trigger_overlaps();
+    query_broadphase_current_ = false; //Responses don't all go through set_position
         
     //Update the camera
     if(camera_target_) {
@@ -375,114 +715,1093 @@ void World::update(double step, bool override_step_mode) {
 
 
     ++step_counter_;
+
+    if(publishing_enabled_) {
+        publish_state();
+    }
 }
 
-void World::destroy_object(ObjectID object_id) {
-    struct PointerCompare {
-        PointerCompare(Object* ptr): ptr_(ptr) {}
-        bool operator()(Object::ptr rhs) { return rhs.get() == ptr_; }
-    
-        Object* ptr_;
-    };
+float World::time_of_impact(Object& object, const kmVec2& motion) {
+    /*
+     *  Sweeps an object's movement for this step against the static geometry
+     *  and returns the fraction of the movement that can be made before it
+     *  reaches a surface. Slow objects are caught by their sensors anyway, so
+     *  we only sweep movements that are longer than the object's extent along
+     *  the direction of movement.
+     *
+     *  A ray is cast from each sweep origin, extended by how far the leading
+     *  edge is ahead of that origin, so that we stop the object with its
+     *  leading edge at the surface rather than its centre. The sensors then
+     *  pick the surface up in the normal collision loop.
+     */
+
+    float distance = kmVec2Length(&motion);
+    if(distance <= 0.0f) {
+        return 1.0f;
+    }
 
-    assert(Object::exists(object_id));
-    Object* obj = Object::get(object_id);
-    objects_.erase(std::remove_if(objects_.begin(), objects_.end(), PointerCompare(obj)), objects_.end());
+    kmVec2 direction;
+    kmVec2Scale(&direction, &motion, 1.0f / distance);
+
+    float extent = object.sweep_extent(direction);
+    if(extent <= 0.0f || distance <= extent) {
+        return 1.0f;
+    }
+
+    kmVec2 origins[MAX_SWEEP_ORIGINS];
+    uint32_t origin_count = object.sweep_origins(origins);
+    assert(origin_count <= MAX_SWEEP_ORIGINS);
+
+    float fraction = 1.0f;
+    kmVec2 intersection, normal;
+
+    for(uint32_t o = 0; o < origin_count; ++o) {
+        //How far the leading edge is ahead of this origin
+        kmVec2 offset;
+        kmVec2Subtract(&offset, &origins[o], &object.position());
+        float lead = std::max(0.0f, extent - kmVec2Dot(&offset, &direction));
+
+        kmRay2 ray;
+        ray.start = origins[o];
+        kmVec2Scale(&ray.dir, &direction, distance + lead);
+
+        float nearest = distance + lead;
+        bool hit = false;
+
+        //Only geometry around the path can be hit
+        kmVec2 end;
+        kmVec2Add(&end, &ray.start, &ray.dir);
+
+        AABB path;
+        path.min = path.max = ray.start;
+        path.include(end);
+
+        geometry_->triangle_grid.query(path, nearby_geometry_);
+        for(uint32_t i: nearby_geometry_) {
+            Triangle& triangle = geometry_->triangles[i];
+            kmScalar hit_distance;
+            if(kmRay2IntersectTriangle(&ray, &triangle.point(0), &triangle.point(1), &triangle.point(2),
+                                       &intersection, &normal, &hit_distance)) {
+                if(hit_distance < nearest) {
+                    nearest = hit_distance;
+                    hit = true;
+                }
+            }
+        }
+
+        geometry_->box_grid.query(path, nearby_geometry_);
+        for(uint32_t i: nearby_geometry_) {
+            Box& box = geometry_->boxes[i];
+            if(kmRay2IntersectBox(&ray, &box.point(0), &box.point(1), &box.point(2), &box.point(3),
+                                  &intersection, &normal)) {
+                float hit_distance = kmVec2DistanceBetween(&ray.start, &intersection);
+                if(hit_distance < nearest) {
+                    nearest = hit_distance;
+                    hit = true;
+                }
+            }
+        }
+
+        geometry_->segment_grid.query(path, nearby_geometry_);
+        for(uint32_t i: nearby_geometry_) {
+            if(::ray_cast(ray, &geometry_->segments[i], &intersection, &normal)) {
+                float hit_distance = kmVec2DistanceBetween(&ray.start, &intersection);
+                if(hit_distance < nearest) {
+                    nearest = hit_distance;
+                    hit = true;
+                }
+            }
+        }
 
-    auto it = all_objects().find(obj->id());
-    if(it != all_objects().end()) {
-        all_objects().erase(it);
+        if(hit) {
+            fraction = std::min(fraction, std::max(0.0f, nearest - lead) / distance);
+        }
     }
 
-    assert(!Object::exists(object_id));
+    return fraction;
 }
-    
-void World::add_triangle(const kmVec2& v1, const kmVec2& v2, const kmVec2& v3) {
-    Triangle new_tri;
 
-    new_tri.points()[0] = v1;
-    new_tri.points()[1] = v2;
-    new_tri.points()[2] = v3;
+static AABB ray_bounds(const SDRay& ray) {
+    kmVec2 end;
+    kmVec2Add(&end, &ray.start, &ray.dir);
 
-    if(compile_callback_) {
-        std::vector<SDuint> indexes = { 0, 1, 2 };
+    AABB bounds;
+    bounds.min = bounds.max = ray.start;
+    bounds.include(end);
+    return bounds;
+}
 
-        SDGeometryHandle new_handle = compile_callback_->callback(
-            SD_RENDER_MODE_TRIANGLES, &new_tri.points()[0], 3, &indexes[0], indexes.size(), compile_callback_->user_data
-        );
+static void record_ray_hit(const SDRay& ray, CollisionPrimitive* primitive, SDQueryHitType type, SDuint id, SDRayHit& hit) {
+    kmVec2 point, normal;
+    if(!ray_cast(ray, primitive, &point, &normal)) {
+        return;
+    }
 
-        new_tri.set_geometry_handle(new_handle);
+    float length = kmVec2Length(&ray.dir);
+    float fraction = (length > 0.0f) ? kmVec2DistanceBetween(&ray.start, &point) / length : 0.0f;
+    if(hit.hit && hit.fraction <= fraction) {
+        return;
     }
 
-    triangles_.push_back(new_tri);
+    hit.hit = true;
+    hit.type = type;
+    hit.id = id;
+    hit.point = point;
+    hit.normal = normal;
+    hit.fraction = fraction;
 }
 
-void World::add_box(const kmVec2& v1, const kmVec2& v2, const kmVec2& v3, const kmVec2& v4) {
-    Box new_box;
-    new_box.point(0) = v1;
-    new_box.point(1) = v2;
-    new_box.point(2) = v3;
-    new_box.point(3) = v4;
+SDuint World::ray_cast(const SDRay* rays, SDuint count, ObjectID ignore, SDRayHit* hits) {
+    /*
+     *  Neighbouring rays in a batch usually go the same way (a fan of line of
+     *  sight checks, a row of shadows) so consecutive rays with overlapping
+     *  bounds are cast as a packet, which looks up the grids once for all of
+     *  them. A ray that goes somewhere else starts a new packet.
+     */
+
+    SDuint hit_count = 0;
+
+    SDuint first = 0;
+    while(first < count) {
+        AABB packet = ray_bounds(rays[first]);
+
+        SDuint end = first + 1;
+        while(end < count && end - first < RAY_PACKET_SIZE) {
+            AABB bounds = ray_bounds(rays[end]);
+            if(!bounds.overlaps(packet)) {
+                break;
+            }
 
-    if(compile_callback_) {
-        std::vector<SDuint> indexes = { 0, 1, 2, 0, 2, 3 };
+            packet.include(bounds.min);
+            packet.include(bounds.max);
+            ++end;
+        }
 
-        SDGeometryHandle new_handle = compile_callback_->callback(
-            SD_RENDER_MODE_TRIANGLES, &new_box.points()[0], 4, &indexes[0], indexes.size(), compile_callback_->user_data
-        );
+        ray_cast_packet(rays + first, end - first, packet, ignore, hits + first);
 
-        new_box.set_geometry_handle(new_handle);
+        for(SDuint i = first; i < end; ++i) {
+            if(hits[i].hit) {
+                ++hit_count;
+            }
+        }
+
+        first = end;
     }
-    
-    boxes_.push_back(new_box);
+
+    return hit_count;
 }
 
-ObjectID World::new_box(float width, float height) {
-    BoxObject::ptr new_box(new BoxObject(this, width, height));
+/*
+ * The rays of a packet, kept as one array per coordinate so that testing every
+ * ray against one candidate is a handful of straight line loops the compiler
+ * can vectorise. Unused lanes have no direction and empty bounds, so they
+ * never overlap or cross anything.
+ *
+ * The results of cross_edge are kept here too, so the compiler can see they
+ * don't overlap the rays and doesn't need to check that before vectorising.
+ */
+struct RayPacket {
+    float start_x[RAY_PACKET_SIZE];
+    float start_y[RAY_PACKET_SIZE];
+    float dir_x[RAY_PACKET_SIZE];
+    float dir_y[RAY_PACKET_SIZE];
+
+    float min_x[RAY_PACKET_SIZE];
+    float min_y[RAY_PACKET_SIZE];
+    float max_x[RAY_PACKET_SIZE];
+    float max_y[RAY_PACKET_SIZE];
+
+    float fractions[RAY_PACKET_SIZE];
+
+    RayPacket(const SDRay* rays, SDuint count) {
+        for(SDuint i = 0; i < RAY_PACKET_SIZE; ++i) {
+            if(i < count) {
+                start_x[i] = rays[i].start.x;
+                start_y[i] = rays[i].start.y;
+                dir_x[i] = rays[i].dir.x;
+                dir_y[i] = rays[i].dir.y;
+
+                AABB bounds = ray_bounds(rays[i]);
+                min_x[i] = bounds.min.x;
+                min_y[i] = bounds.min.y;
+                max_x[i] = bounds.max.x;
+                max_y[i] = bounds.max.y;
+            } else {
+                start_x[i] = start_y[i] = dir_x[i] = dir_y[i] = 0.0f;
+                min_x[i] = min_y[i] = std::numeric_limits<float>::max();
+                max_x[i] = max_y[i] = -std::numeric_limits<float>::max();
+            }
+        }
+    }
 
-    //TODO: Compile for rendering
+    //Sets overlapping[i] for each ray whose bounds overlap other, without branching
+    void overlaps(const AABB& other, uint32_t* overlapping) const {
+        //At -O3 GCC would unroll this into single lanes before it got the chance to vectorise it
+        #pragma GCC unroll 1
+        for(SDuint i = 0; i < RAY_PACKET_SIZE; ++i) {
+            overlapping[i] = (min_x[i] <= other.max.x) & (max_x[i] >= other.min.x) &
+                             (min_y[i] <= other.max.y) & (max_y[i] >= other.min.y);
+        }
+    }
 
-    std::vector<SDVec2> vertices;
-    SDVec2 tmp;
-    float hw = width * 0.5;
-    float hh = height * 0.5;
+    /*
+     * Sets fractions[i] to how far along ray i it crosses the edge from a to b,
+     * heading into the side that normal faces. Rays that miss the edge, or
+     * would cross it from behind, get a fraction past the end of the ray.
+     */
+    void cross_edge(const kmVec2& a, const kmVec2& b, const kmVec2& normal) {
+        const float edge_x = b.x - a.x;
+        const float edge_y = b.y - a.y;
+
+        #pragma GCC unroll 1
+        for(SDuint i = 0; i < RAY_PACKET_SIZE; ++i) {
+            //Solve start + dir * t = a + edge * u
+            float to_x = a.x - start_x[i];
+            float to_y = a.y - start_y[i];
+            float denominator = (dir_x[i] * edge_y) - (dir_y[i] * edge_x);
+            float t = ((to_x * edge_y) - (to_y * edge_x)) / denominator;
+            float u = ((to_x * dir_y[i]) - (to_y * dir_x[i])) / denominator;
+
+            //Parallel rays (and empty lanes) divide by zero, which never compares as crossing
+            uint32_t facing = (dir_x[i] * normal.x) + (dir_y[i] * normal.y) < 0.0f;
+            uint32_t crosses = facing & (t >= 0.0f) & (t <= 1.0f) & (u >= 0.0f) & (u <= 1.0f);
+            fractions[i] = crosses ? t : 2.0f;
+        }
+    }
+};
 
-    kmVec2Fill(&tmp, -hw, -hh);
-    vertices.push_back(tmp);
+/*
+ * Casts the packet at the edges of a piece of static geometry, each edge running
+ * from points[i] to the next point round and facing along normals[i]. Each ray
+ * keeps whichever hit is nearest.
+ */
+static void cast_packet_at_edges(RayPacket& packet, const uint32_t* overlapping,
+                                 const kmVec2* points, uint32_t point_count, uint32_t edge_count, const kmVec2* normals,
+                                 SDQueryHitType type, SDuint id, SDuint count, SDRayHit* hits) {
+    const float* fractions = packet.fractions;
+
+    for(uint32_t e = 0; e < edge_count; ++e) {
+        packet.cross_edge(points[e], points[(e + 1) % point_count], normals[e]);
+
+        for(SDuint i = 0; i < count; ++i) {
+            SDRayHit& hit = hits[i];
+            if(!overlapping[i] || fractions[i] > 1.0f || (hit.hit && hit.fraction <= fractions[i])) {
+                continue;
+            }
 
-    kmVec2Fill(&tmp, hw, -hh);
-    vertices.push_back(tmp);
+            hit.hit = true;
+            hit.type = type;
+            hit.id = id;
+            hit.point.x = packet.start_x[i] + packet.dir_x[i] * fractions[i];
+            hit.point.y = packet.start_y[i] + packet.dir_y[i] * fractions[i];
+            hit.normal = normals[e];
+            hit.fraction = fractions[i];
+        }
+    }
+}
 
-    kmVec2Fill(&tmp, hw, hh);
-    vertices.push_back(tmp);
+void World::ray_cast_packet(const SDRay* rays, SDuint count, const AABB& packet, ObjectID ignore, SDRayHit* hits) {
+    /*
+     *  Each candidate found for the packet is tested against the bounds of
+     *  every ray in one go. The edges of static geometry are then crossed with
+     *  every ray at once too. Objects come in all shapes, so the rays that
+     *  overlap one get the usual intersection test for its shape.
+     */
+
+    RayPacket lanes(rays, count);
+    uint32_t overlapping[RAY_PACKET_SIZE];
+
+    for(SDuint i = 0; i < count; ++i) {
+        SDRayHit& hit = hits[i];
+        hit.hit = false;
+        hit.type = SD_QUERY_HIT_OBJECT;
+        hit.id = 0;
+        hit.fraction = 1.0f;
+    }
 
-    kmVec2Fill(&tmp, -hw, hh);
-    vertices.push_back(tmp);
+    geometry_->triangle_grid.query(packet, nearby_geometry_);
+    for(uint32_t j: nearby_geometry_) {
+        Triangle& triangle = geometry_->triangles[j];
+        lanes.overlaps(triangle.bounds(), overlapping);
 
+        kmVec2 points[3] = { triangle.point(0), triangle.point(1), triangle.point(2) };
+        cast_packet_at_edges(lanes, overlapping, points, 3, 3, triangle.normals(), SD_QUERY_HIT_TRIANGLE, j, count, hits);
+    }
 
-    std::vector<SDuint> indices = { 0, 1, 1, 2, 2, 3, 3, 0 };
+    geometry_->box_grid.query(packet, nearby_geometry_);
+    for(uint32_t j: nearby_geometry_) {
+        Box& box = geometry_->boxes[j];
+        lanes.overlaps(box.bounds(), overlapping);
 
-    if(compile_callback_) {
-        SDGeometryHandle new_handle = compile_callback_->callback(
-            SD_RENDER_MODE_LINES,
-            &vertices[0],
-            vertices.size(),
-            &indices[0],
-            indices.size(),
-            compile_callback_->user_data
-        );
+        kmVec2 points[4] = { box.point(0), box.point(1), box.point(2), box.point(3) };
+        cast_packet_at_edges(lanes, overlapping, points, 4, 4, box.normals(), SD_QUERY_HIT_BOX, j, count, hits);
+    }
 
-        new_box->set_geometry_handle(new_handle);
+    geometry_->segment_grid.query(packet, nearby_geometry_);
+    for(uint32_t j: nearby_geometry_) {
+        Segment& segment = geometry_->segments[j];
+        lanes.overlaps(segment.bounds(), overlapping);
+
+        //Only the front of a segment is solid
+        cast_packet_at_edges(lanes, overlapping, segment.points(), 2, 1, &segment.normal(), SD_QUERY_HIT_SEGMENT, j, count, hits);
     }
 
-    objects_.push_back(new_box);
-    return new_box->id();
+    find_objects(packet, nearby_objects_);
+    for(uint32_t j: nearby_objects_) {
+        Object& object = *objects_[j];
+        if(object.is_trigger() || object.id() == ignore) {
+            continue;
+        }
+
+        lanes.overlaps(object.geom().bounds(), overlapping);
+
+        for(SDuint i = 0; i < count; ++i) {
+            if(overlapping[i]) {
+                record_ray_hit(rays[i], &object.geom(), SD_QUERY_HIT_OBJECT, object.id(), hits[i]);
+            }
+        }
+    }
 }
 
-ObjectID World::new_character() {
-    Character::ptr new_character(new Character(this, 0.5f, 1.0f));
+void World::find_objects(const AABB& area, std::vector<uint32_t>& indexes) {
+    /*
+     *  Finds the objects (by index in objects_) whose bounds overlap the area,
+     *  in index order. Resting objects are already in their grid, the awake
+     *  ones are put in a broadphase of their own the first time they're needed
+     *  after anything has moved.
+     */
+
+    if(!query_broadphase_current_) {
+        query_broadphase_.clear();
+        for(uint32_t i: awake_objects_) {
+            if(!resting_[i]) {
+                query_broadphase_.add(i, objects_[i]->geom().bounds());
+            }
+        }
 
-    RayBox& box = dynamic_cast<RayBox&>(new_character->geom());
+        query_broadphase_.sort();
+        query_broadphase_current_ = true;
+    }
+
+    query_broadphase_.query(area, indexes);
+
+    resting_grid_.query(area, nearby_resting_);
+    std::size_t awake_count = indexes.size();
+    indexes.insert(indexes.end(), nearby_resting_.begin(), nearby_resting_.end());
+    std::inplace_merge(indexes.begin(), indexes.begin() + awake_count, indexes.end());
+
+    //An object that woke more than once is in the awake list twice
+    indexes.erase(std::unique(indexes.begin(), indexes.end()), indexes.end());
+}
+
+SDuint World::query(const AABB& area, SDQueryHit* hits, SDuint capacity) {
+    SDuint count = 0;
+
+    auto add_hits = [&](SDQueryHitType type, const std::vector<uint32_t>& ids) {
+        for(uint32_t id: ids) {
+            if(count == capacity) {
+                return;
+            }
+
+            hits[count].type = type;
+            hits[count].id = id;
+            ++count;
+        }
+    };
+
+    geometry_->triangle_grid.query(area, nearby_geometry_);
+    add_hits(SD_QUERY_HIT_TRIANGLE, nearby_geometry_);
+
+    geometry_->box_grid.query(area, nearby_geometry_);
+    add_hits(SD_QUERY_HIT_BOX, nearby_geometry_);
+
+    geometry_->segment_grid.query(area, nearby_geometry_);
+    add_hits(SD_QUERY_HIT_SEGMENT, nearby_geometry_);
+
+    find_objects(area, nearby_objects_);
+    for(uint32_t i: nearby_objects_) {
+        if(count == capacity) {
+            break;
+        }
+
+        hits[count].type = SD_QUERY_HIT_OBJECT;
+        hits[count].id = objects_[i]->id();
+        ++count;
+    }
+
+    return count;
+}
+
+void World::add_activation_region(SDuint anchor, float half_width, float half_height) {
+    if(activation_regions_.empty()) {
+        activation_check_all_ = true; //Anything can be outside the first region
+    }
+
+    ActivationRegion region;
+    region.anchor = anchor;
+    region.half_width = half_width;
+    region.half_height = half_height;
+    activation_regions_.push_back(region);
+}
+
+void World::clear_activation_regions() {
+    activation_regions_.clear();
+    activation_bounds_.clear();
+    activation_target_ = 0;
+    activation_check_all_ = false;
+
+    for(auto& object: objects_) {
+        if(!object->is_active()) {
+            object->store_previous_position();
+            object->set_active(true);
+        }
+    }
+}
+
+void World::update_activation() {
+    /*
+     *  Works out which objects are inside an activation region this step. The
+     *  regions are centred on their anchor object (or the camera), and anything
+     *  outside all of them is frozen exactly as it is until it comes back into
+     *  one. This only depends on positions at the start of the step, so the same
+     *  inputs always activate the same objects.
+     *
+     *  Awake objects are checked one by one, they're about to be stepped anyway.
+     *  Frozen and sleeping objects are in the resting grid, and one of those can
+     *  only change if it's in a region now or was in one last time, so only the
+     *  grid cells under the regions are visited.
+     */
+
+    if(activation_regions_.empty()) {
+        return;
+    }
+
+    std::vector<AABB> regions;
+    regions.reserve(activation_regions_.size());
+
+    for(const ActivationRegion& region: activation_regions_) {
+        kmVec2 centre = camera_position_;
+        if(region.anchor) {
+            Object* anchor = find_object(region.anchor);
+            if(!anchor) {
+                continue;
+            }
+            centre = anchor->position();
+        }
+
+        AABB bounds;
+        kmVec2Fill(&bounds.min, centre.x - region.half_width, centre.y - region.half_height);
+        kmVec2Fill(&bounds.max, centre.x + region.half_width, centre.y + region.half_height);
+        regions.push_back(bounds);
+    }
+
+    activation_bounds_.swap(regions); //regions now holds last time's
+    regions.insert(regions.end(), activation_bounds_.begin(), activation_bounds_.end());
+
+    std::vector<uint32_t> candidates;
+    if(activation_check_all_) {
+        activation_check_all_ = false;
+        for(uint32_t i = 0; i < objects_.size(); ++i) {
+            candidates.push_back(i);
+        }
+    } else {
+        for(uint32_t i: awake_objects_) {
+            candidates.push_back(i);
+        }
+
+        for(const AABB& region: regions) {
+            resting_grid_.query(region, nearby_objects_);
+            candidates.insert(candidates.end(), nearby_objects_.begin(), nearby_objects_.end());
+        }
+
+        //Whatever the camera was following was kept active, wherever it was
+        Object* old_target = (activation_target_ != camera_target_) ? find_object(activation_target_) : nullptr;
+        Object* target = find_object(camera_target_);
+        for(Object* object: { old_target, target }) {
+            if(object) {
+                candidates.push_back(registry_[object_index(object->id())].simulation_index);
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    }
+
+    activation_target_ = camera_target_;
+
+    for(uint32_t i: candidates) {
+        if(i < objects_.size()) {
+            update_object_activation(*objects_[i]);
+        }
+    }
+}
+
+void World::update_object_activation(Object& object) {
+    //The camera target is always simulated
+    bool active = object.id() == camera_target_;
+
+    const kmVec2& position = object.position();
+    for(const AABB& region: activation_bounds_) {
+        if(active) break;
+
+        active = position.x >= region.min.x && position.x <= region.max.x &&
+                 position.y >= region.min.y && position.y <= region.max.y;
+    }
+
+    if(active && !object.is_active()) {
+        //Don't interpolate from wherever we were frozen
+        object.store_previous_position();
+    }
+
+    object.set_active(active);
+}
+
+void World::wake_all_objects() {
+    for(auto& object: objects_) {
+        object->wake();
+    }
+}
+
+void World::update_trigger_overlaps() {
+    /*
+     *  Works out which objects are inside each trigger, and compares that with
+     *  the last update to generate the enter, stay and exit events. Only the
+     *  bounds are tested, and only against the trigger's broadphase neighbours
+     *  (which cover everything that could have moved into it this step).
+     *  Events are appended, so with a fixed step the events from every sub-step
+     *  of an sdWorldStep are kept.
+     */
+
+    std::vector<TriggerOverlap> overlaps;
+
+    for(uint32_t i: step_objects_) {
+        Object& trigger = *objects_[i];
+        if(!trigger.is_trigger()) {
+            continue;
+        }
+
+        AABB bounds = trigger.geom().bounds();
+        for(uint32_t j: object_neighbours_[i]) {
+            Object& other = *objects_[j];
+            if(!other.is_trigger() && bounds.overlaps(other.geom().bounds())) {
+                overlaps.push_back(std::make_pair(trigger.id(), other.id()));
+            }
+        }
+    }
+
+    std::sort(overlaps.begin(), overlaps.end());
+
+    //Both lists are sorted, so walk them together to find what changed
+    auto previous = trigger_overlaps_.begin();
+    auto current = overlaps.begin();
+
+    while(previous != trigger_overlaps_.end() || current != overlaps.end()) {
+        SDTriggerEvent event;
+
+        if(current == overlaps.end() || (previous != trigger_overlaps_.end() && *previous < *current)) {
+            event.trigger = previous->first;
+            event.object = previous->second;
+            event.type = SD_TRIGGER_EXIT;
+            ++previous;
+        } else if(previous == trigger_overlaps_.end() || *current < *previous) {
+            event.trigger = current->first;
+            event.object = current->second;
+            event.type = SD_TRIGGER_ENTER;
+            ++current;
+        } else {
+            event.trigger = current->first;
+            event.object = current->second;
+            event.type = SD_TRIGGER_STAY;
+            ++previous;
+            ++current;
+        }
+
+        trigger_events_.push_back(event);
+    }
+
+    trigger_overlaps_.swap(overlaps);
+}
+
+SDuint World::get_trigger_events(SDTriggerEvent* events, SDuint capacity) const {
+    SDuint count = std::min<SDuint>(capacity, trigger_events_.size());
+    std::copy(trigger_events_.begin(), trigger_events_.begin() + count, events);
+    return count;
+}
+
+void World::find_object_neighbours() {
+    /*
+     *  Works out which objects could touch each awake object this step, so that
+     *  the object pair test only runs on objects that are actually close
+     *  together. Moving objects are swept by their velocity, and everything is
+     *  padded a little to allow for objects being pushed out of collisions as
+     *  they respond. Only awake objects go through the broadphase, resting ones
+     *  don't move so they're looked up in their grid instead. Each list of
+     *  neighbours ends up in index order, just as if we had tested every object.
+     */
+
+    object_neighbours_.resize(objects_.size());
+
+    broadphase_.clear();
+    for(uint32_t i: step_objects_) {
+        object_neighbours_[i].clear();
+
+        Object& object = *objects_[i];
+
+        AABB bounds = object.geom().bounds();
+        bounds.sweep(object.velocity());
+
+        bounds.min.x -= OBJECT_BROADPHASE_MARGIN;
+        bounds.min.y -= OBJECT_BROADPHASE_MARGIN;
+        bounds.max.x += OBJECT_BROADPHASE_MARGIN;
+        bounds.max.y += OBJECT_BROADPHASE_MARGIN;
+
+        broadphase_.add(i, bounds);
+    }
+
+    broadphase_.find_pairs(broadphase_pairs_);
+
+    for(const BroadphasePair& pair: broadphase_pairs_) {
+        object_neighbours_[pair.first].push_back(pair.second);
+        object_neighbours_[pair.second].push_back(pair.first);
+    }
+
+    for(uint32_t i: step_objects_) {
+        Object& object = *objects_[i];
+
+        //Resting objects aren't padded in their grid, so this is padded by the margin for both
+        AABB bounds = object.geom().bounds();
+        bounds.sweep(object.velocity());
+
+        bounds.min.x -= OBJECT_BROADPHASE_MARGIN * 2.0f;
+        bounds.min.y -= OBJECT_BROADPHASE_MARGIN * 2.0f;
+        bounds.max.x += OBJECT_BROADPHASE_MARGIN * 2.0f;
+        bounds.max.y += OBJECT_BROADPHASE_MARGIN * 2.0f;
+
+        resting_grid_.query(bounds, nearby_objects_);
+        if(nearby_objects_.empty()) {
+            continue;
+        }
+
+        std::vector<uint32_t>& neighbours = object_neighbours_[i];
+        std::size_t awake_count = neighbours.size();
+        neighbours.insert(neighbours.end(), nearby_objects_.begin(), nearby_objects_.end());
+        std::inplace_merge(neighbours.begin(), neighbours.begin() + awake_count, neighbours.end());
+    }
+}
+
+const std::vector<uint32_t>& World::find_pair_candidates(uint32_t i) {
+    /*
+     *  The neighbours that object i runs the pair test against once it has
+     *  moved. A circle (a ring in a ring field, usually) tests every circle
+     *  around it in one batch first, and only keeps the ones it touches.
+     *  Anything else is left for the narrowphase to decide.
+     */
+
+    const std::vector<uint32_t>& neighbours = object_neighbours_[i];
+
+    Circle* circle = dynamic_cast<Circle*>(&objects_[i]->geom());
+    if(!circle) {
+        return neighbours;
+    }
+
+    circle_batch_.clear();
+    for(uint32_t j: neighbours) {
+        if(Circle* other = dynamic_cast<Circle*>(&objects_[j]->geom())) {
+            circle_batch_.add(j, *other);
+        }
+    }
+
+    if(!circle_batch_.size()) {
+        return neighbours;
+    }
+
+    circle_batch_.find_overlaps(*circle);
+
+    //The batch is in the same order as the neighbours, so both are walked together
+    pair_candidates_.clear();
+    uint32_t lane = 0;
+    for(uint32_t j: neighbours) {
+        if(lane < circle_batch_.size() && circle_batch_.index(lane) == j) {
+            if(circle_batch_.overlaps(lane)) {
+                pair_candidates_.push_back(j);
+            }
+            ++lane;
+        } else {
+            pair_candidates_.push_back(j);
+        }
+    }
+
+    return pair_candidates_;
+}
+
+void World::wake_objects_near_movers() {
+    /*
+     *  Wakes any sleeping object that an awake one could touch this step. The
+     *  bounds of each moving object are swept by its velocity so that it wakes
+     *  things before it reaches them, rather than after it has passed through.
+     *  The sleepers are already in the resting grid, so only the movers are
+     *  visited here.
+     */
+
+    std::vector<uint32_t> objects_to_wake;
+    for(uint32_t i: awake_objects_) {
+        Object& object = *objects_[i];
+
+        //Objects that are at rest (like a stack settling) can't wake anything
+        if(object.is_fixed() || kmVec2Length(&object.velocity()) <= sleep_velocity_threshold_) {
+            continue;
+        }
+
+        AABB bounds = object.geom().bounds();
+        bounds.sweep(object.velocity());
+
+        resting_grid_.query(bounds, nearby_objects_);
+        for(uint32_t j: nearby_objects_) {
+            Object& other = *objects_[j];
+            if(other.is_sleeping() && other.is_active()) { //Frozen ones wait until they're back in an activation region
+                objects_to_wake.push_back(j);
+            }
+        }
+    }
+
+    for(uint32_t i: objects_to_wake) {
+        objects_[i]->wake();
+    }
+}
+
+void World::add_object(Object::ptr object) {
+    uint32_t index = objects_.size();
+    objects_.push_back(object);
+
+    registry_[object_index(object->id())].simulation_index = index;
+    resting_.push_back(false);
+    awake_objects_.push_back(index);
+    query_broadphase_current_ = false;
+}
+
+void World::update_resting_object(Object& object) {
+    uint32_t slot = object_index(object.id());
+    if(world_of_object(object.id()) != id_ || slot >= registry_.size() || registry_[slot].object != &object) {
+        return;
+    }
+
+    uint32_t i = registry_[slot].simulation_index;
+    if(i == NOT_SIMULATED) {
+        return;
+    }
+
+    bool was_resting = resting_[i];
+    if(was_resting) {
+        resting_grid_.remove(i);
+    }
+
+    resting_[i] = object.is_frozen();
+    query_broadphase_current_ = false;
+    if(resting_[i]) {
+        resting_grid_.insert(i, object.geom().bounds());
+    } else if(was_resting) {
+        awake_objects_.push_back(i);
+    }
+}
+
+void World::refresh_awake_objects() {
+    //Objects that went to rest are only dropped here, and ones that woke more than once are in twice
+    awake_objects_.erase(
+        std::remove_if(awake_objects_.begin(), awake_objects_.end(), [this](uint32_t i) { return resting_[i]; }),
+        awake_objects_.end()
+    );
+
+    std::sort(awake_objects_.begin(), awake_objects_.end());
+    awake_objects_.erase(std::unique(awake_objects_.begin(), awake_objects_.end()), awake_objects_.end());
+}
+
+void World::rebuild_resting_objects() {
+    //For when objects_ has changed order, everything is put back where it belongs
+    resting_grid_.clear();
+    resting_.assign(objects_.size(), false);
+    awake_objects_.clear();
+    query_broadphase_current_ = false;
+
+    for(uint32_t i = 0; i < objects_.size(); ++i) {
+        Object& object = *objects_[i];
+        registry_[object_index(object.id())].simulation_index = i;
+
+        if(object.is_frozen()) {
+            resting_[i] = true;
+            resting_grid_.insert(i, object.geom().bounds());
+        } else {
+            awake_objects_.push_back(i);
+        }
+    }
+}
+
+void World::destroy_object(ObjectID object_id) {
+    struct PointerCompare {
+        PointerCompare(Object* ptr): ptr_(ptr) {}
+        bool operator()(Object::ptr rhs) { return rhs.get() == ptr_; }
+    
+        Object* ptr_;
+    };
+
+    Object* obj = find_object(object_id);
+    assert(obj);
+
+    //Wake anything that might have been resting on this object
+    resting_grid_.query(obj->geom().bounds(), nearby_objects_);
+    for(uint32_t i: nearby_objects_) {
+        objects_[i]->wake();
+    }
+
+    //Unregister first, erasing from objects_ may delete obj
+    unregister_object(object_id);
+
+    //Forget any responses set up for this object, its ID is stale from here on
+    for(auto it = collision_responses_.begin(); it != collision_responses_.end();) {
+        uint64_t key = it->first;
+        if(ObjectID(key >> 32) == object_id || ObjectID(key & 0xFFFFFFFF) == object_id) {
+            it = collision_responses_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    characters_.erase(std::remove(characters_.begin(), characters_.end(), obj), characters_.end());
+    objects_.erase(std::remove_if(objects_.begin(), objects_.end(), PointerCompare(obj)), objects_.end());
+
+    //Everything after it has moved down one
+    rebuild_resting_objects();
+
+    assert(!find_object(object_id));
+}
+    
+void World::compile_triangle(Triangle& triangle) {
+    if(!compile_callback_) {
+        return;
+    }
+
+    std::vector<SDuint> indexes = { 0, 1, 2 };
+
+    SDGeometryHandle new_handle = compile_callback_->callback(
+        SD_RENDER_MODE_TRIANGLES, &triangle.points()[0], 3, &indexes[0], indexes.size(), compile_callback_->user_data
+    );
+
+    triangle.set_geometry_handle(new_handle);
+}
+
+void World::compile_box(Box& box) {
+    if(!compile_callback_) {
+        return;
+    }
+
+    std::vector<SDuint> indexes = { 0, 1, 2, 0, 2, 3 };
+
+    SDGeometryHandle new_handle = compile_callback_->callback(
+        SD_RENDER_MODE_TRIANGLES, &box.points()[0], 4, &indexes[0], indexes.size(), compile_callback_->user_data
+    );
+
+    box.set_geometry_handle(new_handle);
+}
+
+void World::compile_segment(Segment& segment) {
+    if(!compile_callback_) {
+        return;
+    }
+
+    std::vector<SDuint> indexes = { 0, 1 };
+    std::vector<SDVec2> points(segment.points(), segment.points() + 2);
+
+    SDGeometryHandle new_handle = compile_callback_->callback(
+        SD_RENDER_MODE_LINES, &points[0], 2, &indexes[0], indexes.size(), compile_callback_->user_data
+    );
+
+    segment.set_geometry_handle(new_handle);
+}
+
+StaticGeometry& World::mutable_geometry() {
+    //Shared with a clone, so take a copy before changing anything
+    if(geometry_.use_count() > 1) {
+        geometry_ = std::make_shared<StaticGeometry>(*geometry_);
+    }
+    return *geometry_;
+}
+
+void World::add_triangle(const kmVec2& v1, const kmVec2& v2, const kmVec2& v3) {
+    Triangle new_tri;
+    new_tri.set_points(v1, v2, v3);
+    compile_triangle(new_tri);
+
+    StaticGeometry& geometry = mutable_geometry();
+    geometry.triangle_grid.insert(geometry.triangles.size(), new_tri.bounds());
+    geometry.triangles.push_back(new_tri);
+    wake_all_objects();
+}
+
+SDuint World::compact_geometry(float weld_tolerance) {
+    StaticGeometry& geometry = mutable_geometry();
+    std::vector<Triangle>& triangles = geometry.triangles;
+    std::vector<Box>& boxes = geometry.boxes;
+
+    SDuint before = triangles.size() + boxes.size();
+
+    std::vector<uint32_t> changed_triangles, changed_boxes;
+    ::compact_geometry(triangles, boxes, weld_tolerance, changed_triangles, changed_boxes);
+
+    geometry.triangle_grid.clear();
+    for(uint32_t i = 0; i < triangles.size(); ++i) {
+        geometry.triangle_grid.insert(i, triangles[i].bounds());
+    }
+
+    geometry.box_grid.clear();
+    for(uint32_t i = 0; i < boxes.size(); ++i) {
+        geometry.box_grid.insert(i, boxes[i].bounds());
+    }
+
+    for(uint32_t i: changed_triangles) {
+        compile_triangle(triangles[i]);
+    }
+
+    for(uint32_t i: changed_boxes) {
+        compile_box(boxes[i]);
+    }
+
+    wake_all_objects();
+    return before - (triangles.size() + boxes.size());
+}
+
+void World::add_segment(const Segment& segment) {
+    Segment new_segment = segment;
+    compile_segment(new_segment);
+
+    StaticGeometry& geometry = mutable_geometry();
+    geometry.segment_grid.insert(geometry.segments.size(), new_segment.bounds());
+    geometry.segments.push_back(new_segment);
+    wake_all_objects();
+}
+
+void World::add_segment(const kmVec2& start, const kmVec2& end) {
+    Segment new_segment;
+    new_segment.set_points(start, end);
+    add_segment(new_segment);
+}
+
+void World::add_mesh_surfaces(const kmVec2* points, SDuint num_triangles) {
+    for(const Segment& segment: mesh_surfaces(points, num_triangles, DEFAULT_WELD_TOLERANCE)) {
+        add_segment(segment);
+    }
+}
+
+void World::add_box(const kmVec2& v1, const kmVec2& v2, const kmVec2& v3, const kmVec2& v4) {
+    Box new_box;
+    new_box.set_points(v1, v2, v3, v4);
+    compile_box(new_box);
+
+    StaticGeometry& geometry = mutable_geometry();
+    geometry.box_grid.insert(geometry.boxes.size(), new_box.bounds());
+    geometry.boxes.push_back(new_box);
+    wake_all_objects();
+}
+
+ObjectID World::new_box(float width, float height) {
+    BoxObject::ptr new_box(new BoxObject(this, width, height));
+    if(!new_box->id()) {
+        return 0; //The world is full, register_object has already warned
+    }
+
+    //TODO: Compile for rendering
+
+    std::vector<SDVec2> vertices;
+    SDVec2 tmp;
+    float hw = width * 0.5;
+    float hh = height * 0.5;
+
+    kmVec2Fill(&tmp, -hw, -hh);
+    vertices.push_back(tmp);
+
+    kmVec2Fill(&tmp, hw, -hh);
+    vertices.push_back(tmp);
+
+    kmVec2Fill(&tmp, hw, hh);
+    vertices.push_back(tmp);
+
+    kmVec2Fill(&tmp, -hw, hh);
+    vertices.push_back(tmp);
+
+
+    std::vector<SDuint> indices = { 0, 1, 1, 2, 2, 3, 3, 0 };
+
+    if(compile_callback_) {
+        SDGeometryHandle new_handle = compile_callback_->callback(
+            SD_RENDER_MODE_LINES,
+            &vertices[0],
+            vertices.size(),
+            &indices[0],
+            indices.size(),
+            compile_callback_->user_data
+        );
+
+        new_box->set_geometry_handle(new_handle);
+    }
+
+    add_object(new_box);
+    return new_box->id();
+}
+
+ObjectID World::new_circle(float diameter) {
+    CircleObject::ptr new_circle(new CircleObject(this, diameter));
+    if(!new_circle->id()) {
+        return 0; //The world is full, register_object has already warned
+    }
+
+    const uint32_t SEGMENTS = 16;
+    float radius = diameter * 0.5;
+
+    std::vector<SDVec2> vertices;
+    std::vector<SDuint> indices;
+    for(uint32_t i = 0; i < SEGMENTS; ++i) {
+        float angle = kmDegreesToRadians((360.0f / SEGMENTS) * i);
+
+        SDVec2 tmp;
+        kmVec2Fill(&tmp, cos(angle) * radius, sin(angle) * radius);
+        vertices.push_back(tmp);
+
+        indices.push_back(i);
+        indices.push_back((i + 1) % SEGMENTS);
+    }
+
+    if(compile_callback_) {
+        SDGeometryHandle new_handle = compile_callback_->callback(
+            SD_RENDER_MODE_LINES,
+            &vertices[0],
+            vertices.size(),
+            &indices[0],
+            indices.size(),
+            compile_callback_->user_data
+        );
+
+        new_circle->set_geometry_handle(new_handle);
+    }
+
+    add_object(new_circle);
+    return new_circle->id();
+}
+
+ObjectID World::new_trigger(float width, float height) {
+    Trigger::ptr new_trigger(new Trigger(this, width, height));
+    if(!new_trigger->id()) {
+        return 0; //The world is full, register_object has already warned
+    }
+
+    add_object(new_trigger);
+    return new_trigger->id();
+}
+
+ObjectID World::new_character() {
+    Character::ptr new_character(new Character(this, 0.5f, 1.0f));
+    if(!new_character->id()) {
+        return 0; //The world is full, register_object has already warned
+    }
+
+    RayBox& box = dynamic_cast<RayBox&>(new_character->geom());
 
     std::vector<SDVec2> vertices;
     vertices.push_back(box.ray('A').start);
@@ -522,20 +1841,26 @@ ObjectID World::new_character() {
         new_character->set_geometry_handle(new_handle);
     }
 
-    objects_.push_back(new_character);
+    add_object(new_character);
+    characters_.push_back(static_cast<Character*>(new_character.get()));
     return new_character->id();
 }
 
 ObjectID World::new_spring(float angle, float power) {
-    Spring::ptr new_spring(new Spring(this, angle, power));    
+    Spring::ptr new_spring(new Spring(this, angle, power));
+    if(!new_spring->id()) {
+        return 0; //The world is full, register_object has already warned
+    }
 
-    objects_.push_back(new_spring);
+    add_object(new_spring);
     return new_spring->id();
 }
 
 void World::set_camera_target(SDuint object_id) {
-    Object* obj = Object::get(object_id);
-    assert(obj);
+    Object* obj = find_object(object_id);
+    if(!obj) {
+        throw std::logic_error("Invalid object");
+    }
 
     camera_target_ = object_id;
     camera_position_ = obj->position();
@@ -543,27 +1868,186 @@ void World::set_camera_target(SDuint object_id) {
 
 //=============================================================
 
-static std::map<SDuint, std::tr1::shared_ptr<World> > worlds_;
+ObjectID World::register_object(Object* object) {
+    uint32_t index = 0;
+    if(!free_slots_.empty()) {
+        index = free_slots_.front();
+        free_slots_.pop_front();
+    } else if(registry_.size() <= MAX_OBJECTS_PER_WORLD) {
+        index = registry_.size();
+        registry_.push_back(RegistrySlot());
+    } else {
+        L_WARN("Tried to create more than MAX_OBJECTS_PER_WORLD objects in one world");
+        return 0;
+    }
+
+    RegistrySlot& slot = registry_[index];
+    slot.object = object;
+    return (id_ << OBJECT_HANDLE_BITS) | (slot.generation << OBJECT_INDEX_BITS) | index;
+}
+
+void World::unregister_object(ObjectID object_id) {
+    uint32_t index = object_index(object_id);
+    if(world_of_object(object_id) != id_ || index == 0 || index >= registry_.size()) {
+        return;
+    }
+
+    RegistrySlot& slot = registry_[index];
+    if(!slot.object || slot.generation != object_generation(object_id)) {
+        return;
+    }
+
+    //Move the generation on so the ID we handed out no longer finds this slot
+    slot.object = nullptr;
+    slot.simulation_index = NOT_SIMULATED;
+    slot.generation = (slot.generation + 1) & MAX_OBJECT_GENERATION;
+    free_slots_.push_back(index);
+}
+
+Object* World::find_object(ObjectID object_id) const {
+    uint32_t index = object_index(object_id);
+    if(world_of_object(object_id) != id_ || index >= registry_.size()) {
+        return nullptr;
+    }
+
+    const RegistrySlot& slot = registry_[index];
+    return (slot.generation == object_generation(object_id)) ? slot.object : nullptr;
+}
+
+/*
+ * Worlds are kept in a fixed table indexed by their ID, so finding one is a
+ * single lookup and worlds on different threads never touch the same entry.
+ * Only creating and destroying worlds takes the lock, lookups just load the
+ * entry. Slots are handed out round robin, so an ID is only reused once every
+ * other one has been.
+ */
+static std::atomic<World*> worlds_[MAX_WORLDS + 1];
+static SDuint last_world_id_ = 0;
+static std::mutex worlds_mutex_;
+
+//Puts the world that build() makes for the next free ID into the table, with the lock held
+template<typename Build>
+static SDuint add_world(Build build) {
+    for(SDuint i = 0; i < MAX_WORLDS; ++i) {
+        SDuint new_id = ((last_world_id_ + i) % MAX_WORLDS) + 1;
+        if(!worlds_[new_id].load(std::memory_order_relaxed)) {
+            worlds_[new_id].store(build(new_id), std::memory_order_release);
+            last_world_id_ = new_id;
+            return new_id;
+        }
+    }
+
+    L_WARN("Tried to create more than MAX_WORLDS worlds");
+    return 0;
+}
 
 SDuint World::create() {
-    SDuint new_id = ++world_id_counter_;
-    worlds_[new_id].reset(new World(new_id));
-    return new_id;
+    std::lock_guard<std::mutex> lock(worlds_mutex_);
+    return add_world([](SDuint new_id) { return new World(new_id); });
+}
+
+SDuint World::clone(SDuint world_id) {
+    std::lock_guard<std::mutex> lock(worlds_mutex_);
+
+    World* source = World::get(world_id);
+    if(!source) {
+        L_WARN("Tried to clone a non-existent world");
+        return 0;
+    }
+
+    return add_world([source](SDuint new_id) { return source->clone_into(new_id); });
+}
+
+World* World::clone_into(SDuint new_id) const {
+    std::unique_ptr<World> copy(new World(new_id));
+
+    copy->gravity_ = gravity_;
+    copy->geometry_ = geometry_;
+
+    copy->step_counter_ = step_counter_;
+    copy->fixed_step_ = fixed_step_;
+    copy->max_sub_steps_ = max_sub_steps_;
+    copy->accumulator_ = accumulator_;
+    copy->interpolation_alpha_ = interpolation_alpha_;
+    copy->step_mode_enabled_ = step_mode_enabled_;
+
+    copy->sleeping_enabled_ = sleeping_enabled_;
+    copy->sleep_velocity_threshold_ = sleep_velocity_threshold_;
+    copy->sleep_steps_ = sleep_steps_;
+
+    //Same slots and generations, so IDs stored anywhere just need their world changing
+    copy->registry_ = registry_;
+    copy->free_slots_ = free_slots_;
+    copy->objects_.reserve(objects_.size());
+    for(const Object::ptr& object: objects_) {
+        Object::ptr new_object = object->clone(copy.get());
+        copy->registry_[object_index(new_object->id())].object = new_object.get();
+        copy->objects_.push_back(new_object);
+
+        if(Character* character = dynamic_cast<Character*>(new_object.get())) {
+            copy->characters_.push_back(character);
+        }
+    }
+
+    copy->rebuild_resting_objects();
+
+    for(const TriggerOverlap& overlap: trigger_overlaps_) {
+        copy->trigger_overlaps_.push_back(
+            TriggerOverlap(copy->clone_object_id(overlap.first), copy->clone_object_id(overlap.second))
+        );
+    }
+
+    for(ActivationRegion region: activation_regions_) {
+        if(region.anchor) {
+            region.anchor = copy->clone_object_id(region.anchor);
+        }
+        copy->activation_regions_.push_back(region);
+    }
+    copy->activation_bounds_ = activation_bounds_;
+    copy->activation_target_ = (activation_target_) ? copy->clone_object_id(activation_target_) : 0;
+    copy->activation_check_all_ = activation_check_all_;
+
+    copy->compile_callback_ = compile_callback_;
+    copy->render_callback_ = render_callback_;
+
+    copy->camera_position_ = camera_position_;
+    copy->camera_target_ = (camera_target_) ? copy->clone_object_id(camera_target_) : 0;
+    copy->camera_horizontal_fom_ = camera_horizontal_fom_;
+    copy->camera_horizontal_max_speed_ = camera_horizontal_max_speed_;
+    copy->camera_vertical_fom_ = camera_vertical_fom_;
+    copy->camera_vertical_max_speed_ = camera_vertical_max_speed_;
+
+    copy->object_collision_callback_ = object_collision_callback_;
+    copy->collision_events_enabled_ = collision_events_enabled_;
+
+    for(const auto& response: collision_responses_) {
+        ObjectID lhs = copy->clone_object_id(ObjectID(response.first >> 32));
+        ObjectID rhs = copy->clone_object_id(ObjectID(response.first & 0xFFFFFFFF));
+        copy->collision_responses_[collision_response_key(lhs, rhs)] = response.second;
+    }
+    copy->type_responses_ = type_responses_;
+
+    return copy.release();
 }
 
 void World::destroy(SDuint world_id) {
-    if(worlds_.find(world_id) == worlds_.end()) {
-        L_WARN("Tried to destroy a non-existent world");
-        return;
+    std::unique_ptr<World> world;
+    {
+        std::lock_guard<std::mutex> lock(worlds_mutex_);
+        if(world_id == 0 || world_id > MAX_WORLDS || !worlds_[world_id].load(std::memory_order_relaxed)) {
+            L_WARN("Tried to destroy a non-existent world");
+            return;
+        }
+        world.reset(worlds_[world_id].exchange(nullptr, std::memory_order_acq_rel));
     }
 
-    worlds_.erase(world_id);
+    //The world is deleted here, outside of the lock
 }
 
 World* World::get(SDuint world) {
-    if(worlds_.find(world) == worlds_.end()) {
+    if(world == 0 || world > MAX_WORLDS) {
         return NULL;
     }
 
-    return worlds_[world].get();
+    return worlds_[world].load(std::memory_order_acquire);
 }
@@ -3,6 +3,10 @@
 
 #include <vector>
 #include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <deque>
 
 #include "kazmath/kazmath.h"
 #include "spindash.h"
@@ -10,21 +14,125 @@
 
 #include "collision/triangle.h"
 #include "collision/box.h"
+#include "collision/segment.h"
+#include "collision/broadphase.h"
+#include "collision/spatial_grid.h"
+#include "collision/circle_batch.h"
+
+#include "spsc_queue.h"
+#include "triple_buffer.h"
+
+class Character;
 
 const float DEFAULT_HORIZONTAL_FREEDOM_OF_MOVEMENT = (8.0 / 40.0);
 const float DEFAULT_VERTICAL_FREEDOM_OF_MOVEMENT = (0 / 40.0);
 const float DEFAULT_MAX_HORIZONTAL_CAMERA_SPEED = ((16.0 / 40.0) * 60.0);
 const float DEFAULT_MAX_VERTICAL_CAMERA_SPEED = ((16.0 / 40.0) * 60.0);
+const uint32_t DEFAULT_MAX_SUB_STEPS = 5;
+const float DEFAULT_SLEEP_VELOCITY_THRESHOLD = ((1.0 / 256.0) / 40.0);
+const uint32_t DEFAULT_SLEEP_STEPS = 60;
+const uint32_t DEFAULT_COMMAND_QUEUE_CAPACITY = 1024;
+const float OBJECT_BROADPHASE_MARGIN = 0.1f; //Padding on object bounds in the broadphase
+const uint32_t MAX_OBJECT_TYPES = 32; //Object types go from 1 up to this, zero is untyped
+const uint32_t MAX_COLLISION_TRIES = 10; //How many times an object can respond to collisions in one update
+const float CONVERGENCE_TOLERANCE = 0.0001f; //Responses that move an object less than this don't need another try
+const float STATIC_GRID_CELL_SIZE = 2.0f;
+const float DEFAULT_WELD_TOLERANCE = 0.001f; //Vertices closer than this are the same vertex when compacting geometry
+const uint32_t RAY_PACKET_SIZE = 8; //Up to this many neighbouring rays in a batch share one lookup of the grids
+const float RESTING_CONTACT_DEPTH = 0.01f; //Overlaps up to this deep are left alone so resting contacts stay in contact
+
+/*
+ * Object IDs carry the ID of their world in the top bits, so an object can be
+ * found from its ID alone without a registry shared between worlds. World IDs
+ * go from 1 to MAX_WORLDS, zero means no world.
+ *
+ * Below that is the object's slot in its world's registry, and above the slot
+ * a few generation bits. Slots are reused once their object is destroyed, the
+ * generation changes each time so an old ID doesn't find the new object.
+ */
+const uint32_t WORLD_ID_BITS = 12;
+const uint32_t OBJECT_GENERATION_BITS = 4;
+const uint32_t OBJECT_INDEX_BITS = 32 - WORLD_ID_BITS - OBJECT_GENERATION_BITS;
+const uint32_t OBJECT_HANDLE_BITS = OBJECT_GENERATION_BITS + OBJECT_INDEX_BITS;
+const uint32_t MAX_WORLDS = (1u << WORLD_ID_BITS) - 1;
+const uint32_t MAX_OBJECTS_PER_WORLD = (1u << OBJECT_INDEX_BITS) - 1; //Alive at once, slot zero is never used
+const uint32_t MAX_OBJECT_GENERATION = (1u << OBJECT_GENERATION_BITS) - 1;
+const uint32_t OBJECT_HANDLE_MASK = (1u << OBJECT_HANDLE_BITS) - 1; //The generation and index together
+
+inline SDuint world_of_object(ObjectID object_id) { return object_id >> OBJECT_HANDLE_BITS; }
+inline uint32_t object_index(ObjectID object_id) { return object_id & MAX_OBJECTS_PER_WORLD; }
+inline uint32_t object_generation(ObjectID object_id) { return (object_id >> OBJECT_INDEX_BITS) & MAX_OBJECT_GENERATION; }
 
 typedef std::function<void (SDuint, SDuint, CollisionResponse*, CollisionResponse*)> InternalObjectCollisionCallback;
 
+/*
+ * What happens to an object when it collides with another. With a launch
+ * speed the object is launched at launch_angle (degrees clockwise from up),
+ * otherwise the response's own launch is used.
+ */
+struct ResponseRule {
+    CollisionResponse response = COLLISION_RESPONSE_DEFAULT;
+    float launch_speed = 0.0f;
+    float launch_angle = 0.0f;
+    bool is_set = false;
+};
+
+struct WorldCommand {
+    enum Type {
+        INPUT,
+        SET_POSITION,
+        SET_SPEED
+    };
+
+    Type type;
+    SDuint object;
+    SDuint buttons;
+    kmVec2 value;
+};
+
+/*
+ * The level geometry, which doesn't change while the world runs. Clones of a
+ * world share it, and whichever world changes it first takes its own copy.
+ */
+struct StaticGeometry {
+    std::vector<Triangle> triangles;
+    std::vector<Box> boxes;
+    std::vector<Segment> segments;
+
+    //Indexes into the lists above, so objects only test the geometry around them
+    SpatialGrid triangle_grid{STATIC_GRID_CELL_SIZE};
+    SpatialGrid box_grid{STATIC_GRID_CELL_SIZE};
+    SpatialGrid segment_grid{STATIC_GRID_CELL_SIZE};
+};
+
+struct PublishedState {
+    uint64_t step = 0;
+    std::vector<SDObjectState> objects;
+    std::vector<SDCharacterState> characters;
+};
+
 class World {
 public:
+    /*
+     * Any thread can look a world up, but a world mustn't be destroyed while
+     * another thread is still using it (stepping it, or holding the pointer
+     * get() returned), the caller has to finish with it first.
+     */
     static World* get(SDuint world_id);
     static SDuint create();
     static void destroy(SDuint world_id);
 
-    static SDuint world_id_counter_;
+    /*
+     * Creates a new world that carries on from where this one is, for trying
+     * things out ahead of time and throwing the result away. The static
+     * geometry is shared rather than copied, only the objects are. Objects
+     * keep their slot and generation, so their IDs only differ by the world (see
+     * clone_object_id). Nothing is queued or published in the clone.
+     */
+    static SDuint clone(SDuint world_id);
+    ObjectID clone_object_id(ObjectID object_id) const {
+        return (id_ << OBJECT_HANDLE_BITS) | (object_id & OBJECT_HANDLE_MASK);
+    }
 
     World(SDuint id);
     ~World() {
@@ -36,30 +144,131 @@ public:
 
     void add_triangle(const kmVec2& v1, const kmVec2& v2, const kmVec2& v3);
     void add_box(const kmVec2& v1, const kmVec2& v2, const kmVec2& v3, const kmVec2& v4);
-    void remove_all_triangles() { triangles_.clear(); }
+    void add_segment(const kmVec2& start, const kmVec2& end);
+
+    ///Adds the outline of a triangle mesh as segments, see mesh_surfaces in collision/compact.h
+    void add_mesh_surfaces(const kmVec2* points, SDuint num_triangles);
+    /*
+     * Welds and joins the static geometry once a level is loaded, see
+     * compact_geometry in collision/compact.h. Returns how many triangles and
+     * boxes were removed.
+     */
+    SDuint compact_geometry(float weld_tolerance=DEFAULT_WELD_TOLERANCE);
+
+    void remove_all_triangles() {
+        StaticGeometry& geometry = mutable_geometry();
+        geometry.triangles.clear();
+        geometry.triangle_grid.clear();
+        wake_all_objects(); //Anything resting on the geometry needs to fall
+    }
     
-    ObjectID new_sphere();
+    ObjectID new_circle(float diameter);
     ObjectID new_box(float width, float height);
     ObjectID new_character();
     ObjectID new_spring(float angle, float power);
+    ObjectID new_trigger(float width, float height);
     
     void destroy_object(ObjectID object_id);
 
     void update(double step, bool override_step_mode=false);
 
-    SDuint get_triangle_count() const { return triangles_.size(); }
-    Triangle* get_triangle_at(SDuint i) { return &triangles_[i]; }
+    /*
+     * Advances the world by dt. With a fixed step set this accumulates dt and
+     * runs as many fixed updates as it can (up to the sub-step limit), otherwise
+     * it just runs a single update of dt.
+     */
+    void step(double dt);
+    void set_fixed_step(double step, uint32_t max_sub_steps=DEFAULT_MAX_SUB_STEPS);
+    double fixed_step() const { return fixed_step_; }
+    float interpolation_alpha() const { return interpolation_alpha_; }
+    SDuint get_interpolated_positions(SDuint* objects, SDVec2* positions, SDuint capacity) const;
+
+    SDuint get_object_states(SDObjectState* states, SDuint capacity) const;
+    SDuint get_character_states(SDCharacterState* states, SDuint capacity) const;
+
+    ///The trigger events from the last step(), or debug_step()
+    SDuint trigger_event_count() const { return trigger_events_.size(); }
+    SDuint get_trigger_events(SDTriggerEvent* events, SDuint capacity) const;
+
+    Character* find_character(SDuint character_id) const;
+    void submit_inputs(const SDInputFrame* frames, SDuint count);
+
+    /*
+     * For running update() on its own thread. The game thread queues commands,
+     * which are applied at the start of the next update, and reads back the
+     * state published at the end of the last one. Neither side ever waits, but
+     * there must only be one thread on each side.
+     */
+    bool queue_command(const WorldCommand& command);
+
+    void enable_publishing() { publishing_enabled_ = true; }
+    void disable_publishing() { publishing_enabled_ = false; }
+    bool acquire_published_state() { return published_.acquire(); }
+    const PublishedState& published_state() const { return published_.front(); }
+
+    float time_of_impact(Object& object, const kmVec2& motion);
+
+    /*
+     * Casts rays against the static geometry and every object apart from
+     * triggers and the one with the ignore ID (usually whoever is looking),
+     * filling in the nearest hit of each ray. Returns how many rays hit.
+     */
+    SDuint ray_cast(const SDRay* rays, SDuint count, ObjectID ignore, SDRayHit* hits);
+
+    /*
+     * Lists the static geometry (through the grids) and then the objects (through
+     * the resting grid and the awake objects' broadphase) whose bounds overlap
+     * the area. Returns how many hits were written, at most capacity.
+     */
+    SDuint query(const AABB& area, SDQueryHit* hits, SDuint capacity);
+
+    SDuint get_triangle_count() const { return geometry_->triangles.size(); }
+    Triangle* get_triangle_at(SDuint i) { return &geometry_->triangles[i]; }
     
-    SDuint get_box_count() const { return boxes_.size(); }
-    Box* get_box_at(SDuint i) { return &boxes_.at(i); }
+    SDuint get_box_count() const { return geometry_->boxes.size(); }
+    Box* get_box_at(SDuint i) { return &geometry_->boxes.at(i); }
+
+    SDuint get_segment_count() const { return geometry_->segments.size(); }
+    Segment* get_segment_at(SDuint i) { return &geometry_->segments.at(i); }
     
     uint64_t step_counter() const { return step_counter_; }
+
+    /*
+     * How many collision tries each object update has needed. Entry n counts
+     * the updates that settled after n + 1 tries, and the last entry counts
+     * those that never settled and were moved back to their last safe position.
+     */
+    const std::vector<uint64_t>& tries_histogram() const { return tries_histogram_; }
+    void reset_tries_histogram() { std::fill(tries_histogram_.begin(), tries_histogram_.end(), 0); }
     
     bool debug_mode_enabled() const { return step_mode_enabled_; }
-    void debug_step(double dt) { update(dt, true); }
+    void debug_step(double dt) {
+        clear_step_events();
+        update(dt, true);
+    }
     void enable_debug_mode() { step_mode_enabled_ = true; }
     void disable_debug_mode() { step_mode_enabled_ = false; }		
     
+    bool sleeping_enabled() const { return sleeping_enabled_; }
+    void enable_sleeping() { sleeping_enabled_ = true; }
+    void disable_sleeping() {
+        sleeping_enabled_ = false;
+        wake_all_objects();
+    }
+    void set_sleep_parameters(float velocity_threshold, uint32_t steps) {
+        sleep_velocity_threshold_ = velocity_threshold;
+        sleep_steps_ = std::max<uint32_t>(1, steps);
+    }
+
+    /*
+     * Objects outside every activation region are frozen. Regions are centred
+     * on their anchor object, or on the camera if the anchor is zero. With no
+     * regions (the default) everything is simulated.
+     */
+    void add_activation_region(SDuint anchor, float half_width, float half_height);
+    void clear_activation_regions();
+    SDuint activation_region_count() const { return activation_regions_.size(); }
+
     void set_compile_callback(SDCompileGeometryCallback callback, void* user_data) {
         compile_callback_.reset(new CompileCallback);
         compile_callback_->callback = callback;
@@ -77,9 +286,31 @@ public:
     void set_camera_target(SDuint object_id);
     const kmVec2& camera_position() const { return camera_position_; }
 
-    static std::map<ObjectID, Object*>& all_objects() {
-        static std::map<ObjectID, Object*> objs;
-        return objs;
+    /*
+     * Every object built in this world registers itself here (including ones
+     * that are never added to the simulation, like those in the tests), this
+     * is what hands out their IDs. Zero is returned once every slot is taken.
+     */
+    ObjectID register_object(Object* object);
+    void unregister_object(ObjectID object_id);
+    Object* find_object(ObjectID object_id) const;
+
+    /*
+     * Sleeping and frozen objects don't move, so rather than going through the
+     * broadphase and the update loop every step they're kept in a grid of
+     * their own. Objects call this whenever they fall asleep, wake, are frozen
+     * or thawed, or are moved while frozen, and it's the only time the grid
+     * changes.
+     */
+    void update_resting_object(Object& object);
+
+    ///Objects call this whenever they're moved, so queries don't use out of date bounds
+    void object_moved(Object& object) {
+        if(object.is_frozen()) {
+            update_resting_object(object);
+        } else {
+            query_broadphase_current_ = false;
+        }
     }
 
 
@@ -87,18 +318,131 @@ public:
         object_collision_callback_ = callback;
     }
 
+    /*
+     * With collision events enabled, object pairs that collide are recorded
+     * for the caller to read after the step, instead of calling the collision
+     * callback in the middle of it. The responses then come from the table
+     * set up with set_collision_response, any pair not in it gets the default.
+     */
+    void enable_collision_events() { collision_events_enabled_ = true; }
+    void disable_collision_events() { collision_events_enabled_ = false; }
+    bool collision_events_enabled() const { return collision_events_enabled_; }
+    SDuint collision_event_count() const { return collision_events_.size(); }
+    SDuint get_collision_events(SDCollisionEvent* events, SDuint capacity) const;
+
+    void set_collision_response(ObjectID lhs, ObjectID rhs, CollisionResponse lhs_response, CollisionResponse rhs_response);
+    void clear_collision_responses() { collision_responses_.clear(); }
+
+    /*
+     * Sets the rule for objects of one type colliding with objects of another,
+     * this is used for any pair of objects without a response of their own.
+     * The rules are kept in a flat MAX_OBJECT_TYPES square matrix, so finding
+     * one is a single lookup however many are set.
+     */
+    void set_type_response(SDuint type, SDuint other_type, const ResponseRule& rule);
+    void clear_type_responses() { type_responses_.clear(); }
+
 private:
     SDuint id_;
     kmVec2 gravity_;
 
-    std::vector<Triangle> triangles_;
-    std::vector<Box> boxes_;
+    std::shared_ptr<StaticGeometry> geometry_;
+    StaticGeometry& mutable_geometry();
+
+    World* clone_into(SDuint new_id) const;
+
     std::vector<Object::ptr> objects_;
+    std::vector<Character*> characters_; //The characters in objects_ in creation order, so we don't have to cast to find them
+
+    static const uint32_t NOT_SIMULATED = ~0u; //Registered, but never added to objects_ (the tests do this)
+
+    struct RegistrySlot {
+        Object* object = nullptr;
+        uint32_t generation = 0;
+        uint32_t simulation_index = NOT_SIMULATED; //Where the object is in objects_
+    };
+
+    std::vector<RegistrySlot> registry_ = std::vector<RegistrySlot>(1); //Indexed by object_index, zero is never used
+    std::deque<uint32_t> free_slots_; //Oldest first, so a slot's generation goes round as slowly as possible
 
     uint64_t step_counter_;
+
+    double fixed_step_ = 0.0; //Zero means variable stepping
+    uint32_t max_sub_steps_ = DEFAULT_MAX_SUB_STEPS;
+    double accumulator_ = 0.0;
+    float interpolation_alpha_ = 1.0f;
     
     bool step_mode_enabled_;
 
+    bool sleeping_enabled_ = false;
+    float sleep_velocity_threshold_ = DEFAULT_SLEEP_VELOCITY_THRESHOLD;
+    uint32_t sleep_steps_ = DEFAULT_SLEEP_STEPS;
+
+    std::vector<uint32_t> nearby_geometry_;
+
+    void compile_triangle(Triangle& triangle);
+    void compile_box(Box& box);
+    void compile_segment(Segment& segment);
+    void add_segment(const Segment& segment);
+
+    void ray_cast_packet(const SDRay* rays, SDuint count, const AABB& packet, ObjectID ignore, SDRayHit* hits);
+
+    Broadphase query_broadphase_; //The awake objects as they are now, built when a query needs it
+    bool query_broadphase_current_ = false;
+    std::vector<uint32_t> nearby_resting_;
+    void find_objects(const AABB& area, std::vector<uint32_t>& indexes);
+
+    std::vector<uint64_t> tries_histogram_ = std::vector<uint64_t>(MAX_COLLISION_TRIES + 1);
+
+    void add_object(Object::ptr object);
+
+    SpatialGrid resting_grid_{STATIC_GRID_CELL_SIZE}; //Frozen objects, by index in objects_
+    std::vector<uint8_t> resting_; //By index in objects_, whether it's in resting_grid_
+    std::vector<uint32_t> awake_objects_; //Everything else. Only tidied up by refresh_awake_objects
+    std::vector<uint32_t> step_objects_; //The awake objects as this step started, in index order
+    std::vector<uint32_t> nearby_objects_;
+    void refresh_awake_objects();
+    void rebuild_resting_objects();
+
+    Broadphase broadphase_; //Awake objects only
+    std::vector<BroadphasePair> broadphase_pairs_;
+    std::vector<std::vector<uint32_t>> object_neighbours_; //Objects that might touch each awake object this step
+    std::vector<std::vector<uint32_t>> earlier_contacts_;
+    void find_object_neighbours();
+
+    CircleBatch circle_batch_; //The circles around the circle being stepped
+    std::vector<uint32_t> pair_candidates_;
+    const std::vector<uint32_t>& find_pair_candidates(uint32_t i);
+
+    typedef std::pair<SDuint, SDuint> TriggerOverlap; //Trigger ID, object ID
+    std::vector<TriggerOverlap> trigger_overlaps_; //Sorted, as of the last update
+    std::vector<SDTriggerEvent> trigger_events_;
+    void update_trigger_overlaps();
+
+    struct ActivationRegion {
+        SDuint anchor;
+        float half_width;
+        float half_height;
+    };
+
+    std::vector<ActivationRegion> activation_regions_;
+    std::vector<AABB> activation_bounds_; //Where the regions were at the last update_activation
+    SDuint activation_target_ = 0; //The camera target at the last update_activation
+    bool activation_check_all_ = false; //Until the first regions are applied, everything is active
+    void update_activation();
+    void update_object_activation(Object& object);
+
+    SPSCQueue<WorldCommand> commands_{DEFAULT_COMMAND_QUEUE_CAPACITY};
+    void apply_queued_commands();
+
+    std::atomic<bool> publishing_enabled_{false}; //Set from the game thread, read in update()
+    TripleBuffer<PublishedState> published_;
+    void publish_state();
+
+    void wake_all_objects();
+    void wake_objects_near_movers();
+    static bool is_resting_contact(const std::vector<Collision>& collisions);
+
     struct CompileCallback {
         SDCompileGeometryCallback callback;
         void* user_data;
@@ -122,7 +466,22 @@ private:
 
     InternalObjectCollisionCallback object_collision_callback_;
 
-    void handle_collision_response(Object& obj, Object& other, CollisionResponse response_type, const std::vector<Collision>& collisions);
+    bool collision_events_enabled_ = false;
+    std::vector<SDCollisionEvent> collision_events_;
+
+    //Keyed by the pair of object IDs, lowest first, the responses are in the same order
+    std::unordered_map<uint64_t, std::pair<CollisionResponse, CollisionResponse>> collision_responses_;
+    std::vector<ResponseRule> type_responses_; //Indexed by (type * MAX_OBJECT_TYPES) + other_type, empty until one is set
+    const ResponseRule* find_type_response(SDuint type, SDuint other_type) const;
+
+    void find_collision_responses(Object& lhs, Object& rhs, ResponseRule* lhs_rule, ResponseRule* rhs_rule);
+
+    void clear_step_events() {
+        trigger_events_.clear();
+        collision_events_.clear();
+    }
+
+    void handle_collision_response(Object& obj, Object& other, const ResponseRule& rule, const std::vector<Collision>& collisions);
 
     friend class Object;
 };
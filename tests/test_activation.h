@@ -0,0 +1,105 @@
+#ifndef TEST_ACTIVATION_H
+#define TEST_ACTIVATION_H
+
+#include "world_test_case.h"
+
+class TestActivationRegions : public WorldTestCase {
+public:
+    void test_everything_active_by_default() {
+        SDuint box = sdBoxCreate(world_, 1.0, 1.0);
+        sdObjectSetPosition(box, 1000, 1000);
+        sdWorldStep(world_, TWORLD::frame_time);
+
+        assert_true(sdObjectIsActive(box));
+    }
+
+    void test_objects_outside_region_are_frozen() {
+        sdWorldAddActivationRegion(world_, 0, 10, 10); //Around the camera, at the origin
+
+        SDuint near = sdBoxCreate(world_, 1.0, 1.0);
+        sdObjectSetSpeedX(near, 1.0);
+
+        SDuint far = sdBoxCreate(world_, 1.0, 1.0);
+        sdObjectSetPosition(far, 100, 0);
+        sdObjectSetSpeedX(far, -1.0);
+
+        sdWorldStep(world_, TWORLD::frame_time);
+
+        assert_true(sdObjectIsActive(near));
+        assert_false(sdObjectIsActive(far));
+        assert_equal(1, sdObjectGetPositionX(near));
+        assert_equal(100, sdObjectGetPositionX(far));
+        assert_equal(-1, sdObjectGetSpeedX(far)); //State is kept while frozen
+
+        //Moving it back into the region reactivates it
+        sdObjectSetPosition(far, 5, 0);
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_true(sdObjectIsActive(far));
+        assert_equal(4, sdObjectGetPositionX(far));
+
+        sdWorldClearActivationRegions(world_);
+        sdObjectSetPosition(far, 100, 0);
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_true(sdObjectIsActive(far));
+    }
+
+    void test_regions_follow_their_anchor() {
+        SDuint player_one = sdBoxCreate(world_, 1.0, 1.0);
+        SDuint player_two = sdBoxCreate(world_, 1.0, 1.0);
+        sdObjectSetPosition(player_two, 100, 0);
+
+        SDuint prop = sdBoxCreate(world_, 1.0, 1.0);
+        sdObjectSetPosition(prop, 105, 0);
+
+        sdWorldAddActivationRegion(world_, player_one, 10, 10);
+        sdWorldStep(world_, TWORLD::frame_time);
+
+        assert_true(sdObjectIsActive(player_one));
+        assert_false(sdObjectIsActive(player_two));
+        assert_false(sdObjectIsActive(prop));
+
+        //Split-screen, the second player gets their own region
+        sdWorldAddActivationRegion(world_, player_two, 10, 10);
+        sdWorldStep(world_, TWORLD::frame_time);
+
+        assert_true(sdObjectIsActive(player_two));
+        assert_true(sdObjectIsActive(prop));
+    }
+
+    void test_sleepers_left_behind_are_frozen() {
+        sdWorldEnableSleeping(world_);
+        sdWorldSetSleepParameters(world_, 0.001, 1);
+
+        SDuint player = sdBoxCreate(world_, 1.0, 1.0);
+        SDuint sleeper = sdBoxCreate(world_, 1.0, 1.0);
+        sdObjectSetPosition(sleeper, 5, 0);
+
+        sdWorldAddActivationRegion(world_, player, 10, 10);
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_true(sdObjectIsSleeping(sleeper));
+        assert_true(sdObjectIsActive(sleeper));
+
+        //The region moves away from something that isn't being stepped
+        sdObjectSetPosition(player, 100, 0);
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_false(sdObjectIsActive(sleeper));
+
+        sdObjectSetPosition(player, 0, 0);
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_true(sdObjectIsActive(sleeper));
+    }
+
+    void test_camera_target_is_always_active() {
+        SDuint character = sdCharacterCreate(world_);
+        sdWorldCameraTarget(world_, character);
+
+        SDuint anchor = sdBoxCreate(world_, 1.0, 1.0);
+        sdObjectSetPosition(anchor, 1000, 1000);
+        sdWorldAddActivationRegion(world_, anchor, 1, 1);
+
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_true(sdObjectIsActive(character));
+    }
+};
+
+#endif // TEST_ACTIVATION_H
@@ -0,0 +1,74 @@
+#ifndef TEST_BATCHED_API_H
+#define TEST_BATCHED_API_H
+
+#include "world_test_case.h"
+
+class TestBatchedAPI : public WorldTestCase {
+public:
+    void test_object_states() {
+        SDuint box = sdBoxCreate(world_, 1.0, 1.0);
+        sdObjectSetPosition(box, 1, 2);
+        sdObjectSetSpeedX(box, 3);
+        sdObjectSetSpeedY(box, 4);
+
+        SDuint character = sdCharacterCreate(world_);
+        sdObjectSetPosition(character, 5, 6);
+
+        SDObjectState states[4];
+        assert_equal(2, sdWorldGetObjectStates(world_, states, 4));
+
+        assert_equal(box, states[0].object);
+        assert_equal(1, states[0].position.x);
+        assert_equal(2, states[0].position.y);
+        assert_equal(3, states[0].speed.x);
+        assert_equal(4, states[0].speed.y);
+        assert_equal(sdObjectGetRotation(box), states[0].rotation);
+
+        assert_equal(character, states[1].object);
+        assert_equal(5, states[1].position.x);
+        assert_equal(6, states[1].position.y);
+
+        //Only capacity states are written
+        assert_equal(1, sdWorldGetObjectStates(world_, states, 1));
+    }
+
+    void test_character_states() {
+        sdBoxCreate(world_, 1.0, 1.0);
+        SDuint character = sdCharacterCreate(world_);
+        sdCharacterSetGroundSpeed(character, 0.5);
+
+        SDCharacterState states[2];
+        assert_equal(1, sdWorldGetCharacterStates(world_, states, 2));
+
+        assert_equal(character, states[0].character);
+        assert_equal(sdCharacterAnimationState(character), states[0].animation_state);
+        assert_equal(sdCharacterFacingDirection(character), states[0].facing);
+        assert_equal(sdCharacterIsGrounded(character), states[0].grounded);
+        assert_equal(0.5, states[0].ground_speed);
+
+        sdObjectDestroy(character);
+        assert_equal(0, sdWorldGetCharacterStates(world_, states, 2));
+    }
+
+    void test_submit_inputs() {
+        SDuint left = sdCharacterCreate(world_);
+        SDuint right = sdCharacterCreate(world_);
+        SDuint both = sdCharacterCreate(world_);
+
+        SDInputFrame frames[] = {
+            { left, SD_INPUT_LEFT },
+            { right, SD_INPUT_RIGHT },
+            { both, SD_INPUT_LEFT | SD_INPUT_RIGHT },
+            { 9999, SD_INPUT_JUMP } //Unknown characters are skipped
+        };
+
+        sdWorldSubmitInputs(world_, frames, 4);
+        sdWorldStep(world_, TWORLD::frame_time);
+
+        assert_true(sdObjectGetSpeedX(left) < 0);
+        assert_true(sdObjectGetSpeedX(right) > 0);
+        assert_equal(0, sdObjectGetSpeedX(both)); //Opposites cancel out
+    }
+};
+
+#endif // TEST_BATCHED_API_H
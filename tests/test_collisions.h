@@ -7,6 +7,13 @@
 #include "spindash/collision/collide.h"
 #include "spindash/collision/ray_box.h"
 #include "spindash/collision/box.h"
+#include "spindash/collision/circle.h"
+#include "spindash/collision/circle_batch.h"
+#include "spindash/collision/triangle.h"
+#include "spindash/collision/spatial_grid.h"
+#include "spindash/collision/segment.h"
+#include "spindash/collision/compact.h"
+#include "spindash/world.h"
 
 const SDVec2 box_points[] = {
     { -5, -5 },
@@ -33,6 +40,95 @@ public:
         assert_equal(0.0, collisions[1].point.y);
     }
 
+    void test_ray_box_keeps_nearest_hit_per_sensor() {
+        RayBox ray_box(nullptr, 0.5f, 4.0f);
+        ray_box.set_position(0, 2.0);
+
+        Box floor(nullptr, 10.0f, 1.0f);
+        floor.set_position(0, -0.5);
+
+        //A step under B only
+        Box step(nullptr, 1.0f, 1.0f);
+        step.set_position(0.5, 0.5);
+
+        collide_sensors(&ray_box, &step);
+        collide_sensors(&ray_box, &floor); //Further away, so B keeps the step
+
+        assert_true(ray_box.nearest_hit(SENSOR_A).found);
+        assert_equal(0.0, ray_box.nearest_hit(SENSOR_A).point.y);
+        assert_equal(2.0, ray_box.nearest_hit(SENSOR_A).distance);
+        assert_equal(1.0, ray_box.nearest_hit(SENSOR_A).normal.y);
+
+        assert_true(ray_box.nearest_hit(SENSOR_B).found);
+        assert_equal(1.0, ray_box.nearest_hit(SENSOR_B).point.y);
+        assert_equal(1.0, ray_box.nearest_hit(SENSOR_B).distance);
+
+        assert_false(ray_box.nearest_hit(SENSOR_C).found);
+        assert_false(ray_box.nearest_hit(SENSOR_L).found);
+
+        ray_box.clear_hits();
+        assert_false(ray_box.nearest_hit(SENSOR_A).found);
+
+        //The full narrowphase records them too
+        collide(&ray_box, &floor);
+        assert_true(ray_box.nearest_hit(SENSOR_B).found);
+        assert_equal(0.0, ray_box.nearest_hit(SENSOR_B).point.y);
+    }
+
+    void test_sensor_hits_carry_surface_angles() {
+        RayBox ray_box(nullptr, 0.5f, 1.0f);
+        ray_box.set_position(0, 0.5);
+
+        //A 45 degree slope going up to the left
+        kmVec2 a, b, c;
+        kmVec2Fill(&a, -5, 5);
+        kmVec2Fill(&b, -5, -5);
+        kmVec2Fill(&c, 5, -5);
+
+        Triangle slope;
+        slope.set_points(a, b, c);
+
+        collide_sensors(&ray_box, &slope);
+
+        const SensorHit& hit = ray_box.nearest_hit(SENSOR_A);
+        assert_true(hit.found);
+        assert_close(45.0, hit.angle.degrees, 0.001);
+        assert_close(std::sqrt(0.5), hit.angle.sin, 0.0001);
+        assert_close(std::sqrt(0.5), hit.angle.cos, 0.0001);
+
+        //Straight from the triangle, not worked out again
+        const SurfaceAngle* edge = std::find_if(slope.angles(), slope.angles() + 3, [](const SurfaceAngle& angle) {
+            return std::fabs(angle.degrees - 45.0f) < 0.001f;
+        });
+        assert_true(edge != slope.angles() + 3);
+        assert_equal(edge->sin, hit.angle.sin);
+
+        //Characters take the angle of the ground from the hit
+        Character ch(nullptr, 0.5, 1.0);
+        ch.set_position(0, 0.5);
+        collide(&ch.geom(), &slope);
+        ch.respond_to(std::vector<Collision>());
+        assert_close(45.0, ch.rotation(), 0.001);
+    }
+
+    void test_box_points_follow_transform() {
+        Box box(nullptr, 4.0f, 2.0f);
+        box.set_position(10, 0);
+        box.set_position(10, 20);
+
+        assert_close(8, box.point(0).x, 0.001);
+        assert_close(19, box.point(0).y, 0.001);
+
+        box.set_rotation(90);
+        assert_close(11, box.point(0).x, 0.001);
+        assert_close(18, box.point(0).y, 0.001);
+
+        //Moving keeps the rotation
+        box.set_position(0, 0);
+        assert_close(1, box.point(0).x, 0.001);
+        assert_close(-2, box.point(0).y, 0.001);
+    }
+
     void test_negative_angle_calculations() {
         Character ch(nullptr, 0.5, 1.0);
         ch.set_position(5, 5);
@@ -70,6 +166,335 @@ public:
         assert_close(55.0f, ch.rotation(), 0.01);
         assert_equal(QUADRANT_LEFT_WALL, ch.quadrant());
     }
+
+    void test_fast_movement_stops_at_thin_geometry() {
+        World world(0);
+        Character ch(&world, 0.5, 1.0);
+        ch.set_position(0, 2);
+
+        //A floor much thinner than a single step of movement
+        kmVec2 a, b, c;
+        kmVec2Fill(&a, -10, 0);
+        kmVec2Fill(&b, -10, -0.01);
+        kmVec2Fill(&c, 10, 0);
+        world.add_triangle(a, b, c);
+
+        kmVec2 motion;
+
+        //Slow movement is left to the sensors
+        kmVec2Fill(&motion, 0, -0.2);
+        assert_equal(1.0f, world.time_of_impact(ch, motion));
+
+        //Fast movement stops with the leading edge at the surface
+        kmVec2Fill(&motion, 0, -5);
+        assert_close((2.0 - 0.5) / 5.0, world.time_of_impact(ch, motion), 0.0001);
+
+        ch.set_velocity(0, -5);
+        ch.update(1.0 / 60.0);
+        assert_close(0.5, ch.position().y, 0.0001);
+    }
+
+    void test_fast_movement_stops_at_a_ledge_under_one_foot() {
+        World world(0);
+        Character ch(&world, 0.5, 1.0);
+        ch.set_position(0, 2);
+
+        //Only the right foot is over this, the centre would drop past it
+        kmVec2 a, b, c;
+        kmVec2Fill(&a, 0.1, 0);
+        kmVec2Fill(&b, 0.1, -0.01);
+        kmVec2Fill(&c, 10, 0);
+        world.add_triangle(a, b, c);
+
+        kmVec2 motion;
+        kmVec2Fill(&motion, 0, -5);
+        assert_close((2.0 - 0.5) / 5.0, world.time_of_impact(ch, motion), 0.0001);
+    }
+
+    void test_box_triangle_manifold() {
+        Box box(nullptr, 2.0f, 2.0f);
+        box.set_position(0, 0.9); //Sunk 0.1 into the floor
+
+        kmVec2 a, b, c;
+        kmVec2Fill(&a, -10, 0);
+        kmVec2Fill(&b, -10, -1);
+        kmVec2Fill(&c, 10, 0);
+
+        Triangle floor;
+        floor.set_points(a, b, c);
+
+        std::vector<Collision> collisions = collide(&box, &floor);
+
+        //Both bottom corners are in contact
+        assert_equal(2, collisions.size());
+        for(const Collision& collision: collisions) {
+            assert_close(0.1, collision.depth, 0.0001);
+            assert_close(0, collision.point.y, 0.0001);
+
+            //The floor's normal points up at the box
+            assert_close(1, collision.b_normal.y, 0.0001);
+            assert_close(-1, collision.a_normal.y, 0.0001);
+        }
+
+        //Swapping the order swaps the normals
+        collisions = collide(&floor, &box);
+        assert_equal(2, collisions.size());
+        assert_close(1, collisions[0].a_normal.y, 0.0001);
+
+        box.set_position(0, 1.5);
+        assert_true(collide(&box, &floor).empty());
+    }
+
+    void test_box_box_separating_axis() {
+        Box lhs(nullptr, 1.0f, 1.0f);
+        Box rhs(nullptr, 1.0f, 1.0f);
+
+        //Overlapping bounds, but the rotated box doesn't actually touch
+        rhs.set_rotation(45);
+        rhs.set_position(0.95, 0.95);
+        assert_true(collide(&lhs, &rhs).empty());
+
+        rhs.set_rotation(0);
+        rhs.set_position(0.8, 0.25);
+
+        std::vector<Collision> collisions = collide(&lhs, &rhs);
+        assert_equal(2, collisions.size());
+        assert_close(0.2, collisions[0].depth, 0.0001);
+        assert_close(1, collisions[0].a_normal.x, 0.0001);
+    }
+
+    void test_ray_box_sensors_hit_other_ray_box_body() {
+        RayBox top(nullptr, 0.5f, 1.0f);
+        RayBox bottom(nullptr, 0.5f, 1.0f);
+        bottom.set_body_size(0.5f, 0.8f);
+
+        //Far apart, nothing to test
+        top.set_position(5, 5);
+        assert_true(collide(&top, &bottom).empty());
+
+        //The floor sensors of the top box reach the head of the bottom one
+        top.set_position(0, 0.85);
+        std::vector<Collision> collisions = collide(&top, &bottom);
+
+        uint32_t floor_hits = 0;
+        for(Collision& c: collisions) {
+            if(c.a_ray == 'A' || c.a_ray == 'B') {
+                assert_close(0.4, c.point.y, 0.0001);
+                assert_close(1.0, c.b_normal.y, 0.0001);
+                ++floor_hits;
+            }
+        }
+        assert_equal(2, floor_hits);
+
+        //Within sensor reach, but the bodies are smaller than the sensor boxes
+        top.set_body_size(0.5f, 0.8f);
+        top.set_position(0, 0.95);
+        assert_true(collide(&top, &bottom).empty());
+    }
+
+    void test_circle_polygon_collisions() {
+        Box floor(nullptr, 10.0f, 1.0f);
+        floor.set_position(0, -0.5);
+
+        Circle circle(nullptr, 0.5f);
+        circle.set_position(0, 0.4);
+
+        std::vector<Collision> collisions = collide(&circle, &floor);
+        assert_equal(1, collisions.size());
+        assert_close(0.1, collisions[0].depth, 0.0001);
+        assert_close(1.0, collisions[0].b_normal.y, 0.0001); //The floor's normal points up at the circle
+        assert_close(-1.0, collisions[0].a_normal.y, 0.0001);
+        assert_close(0.0, collisions[0].point.y, 0.0001);
+
+        //Past the corner of the floor, the bounds overlap but the circle doesn't
+        circle.set_position(5.4, 0.4);
+        assert_true(collide(&circle, &floor).empty());
+
+        //Touching the corner pushes out diagonally
+        circle.set_position(5.3, 0.3);
+        collisions = collide(&floor, &circle);
+        assert_equal(1, collisions.size());
+        assert_close(kmVec2Length(&collisions[0].a_normal), 1.0, 0.0001);
+        assert_close(collisions[0].a_normal.x, collisions[0].a_normal.y, 0.0001);
+
+        Triangle slope;
+        kmVec2 p1 = { -5, 0 }, p2 = { 5, 0 }, p3 = { 5, 10 };
+        slope.set_points(p1, p2, p3);
+
+        circle.set_position(0, 0.25);
+        collisions = collide(&slope, &circle);
+        assert_equal(1, collisions.size());
+        assert_true(collisions[0].a_normal.y < 0); //Pushed out through the slope, not the floor
+    }
+
+    void test_circle_circle_and_ray_box_collisions() {
+        Circle a(nullptr, 0.5f);
+        Circle b(nullptr, 0.5f);
+        b.set_position(0.8, 0);
+
+        std::vector<Collision> collisions = collide(&a, &b);
+        assert_equal(1, collisions.size());
+        assert_close(0.2, collisions[0].depth, 0.0001);
+        assert_close(1.0, collisions[0].a_normal.x, 0.0001);
+        assert_close(0.5, collisions[0].point.x, 0.0001);
+
+        b.set_position(1.1, 0);
+        assert_true(collide(&a, &b).empty());
+
+        //A character standing on a circle hits it with its floor sensors
+        RayBox ray_box(nullptr, 0.5f, 1.0f);
+        ray_box.set_position(0, 0.9);
+
+        collisions = collide(&ray_box, &a);
+        assert_equal(2, collisions.size());
+        for(Collision& c: collisions) {
+            assert_true(c.a_ray == 'A' || c.a_ray == 'B');
+            assert_true(c.b_normal.y > 0);
+            assert_close(0.5, kmVec2Length(&c.point), 0.0001); //On the circle's edge
+        }
+    }
+    void test_circle_batch_overlaps() {
+        Circle ring(nullptr, 0.5f);
+        ring.set_position(10, 0);
+
+        //A field of rings a metre apart, more than fit in one lane of the batch
+        CircleBatch batch;
+        std::vector<Circle> field(12, Circle(nullptr, 0.25f));
+        for(uint32_t i = 0; i < field.size(); ++i) {
+            field[i].set_position(float(i) * 1.0f + 5.0f, 0.5f);
+            batch.add(i * 2, field[i]);
+        }
+        assert_equal(12, batch.size());
+        assert_equal(22, batch.index(11));
+
+        batch.find_overlaps(ring);
+
+        //Only the ring straight above is within reach, the ones either side are just too far
+        for(uint32_t i = 0; i < batch.size(); ++i) {
+            bool touching = !collide(&ring, &field[i]).empty();
+            assert_equal(touching, batch.overlaps(i));
+            assert_equal(i == 5, batch.overlaps(i));
+        }
+
+        batch.clear();
+        assert_equal(0, batch.size());
+    }
+
+    void test_spatial_grid_query() {
+        SpatialGrid grid(1.0f);
+
+        AABB small = { { 0.2, 0.2 }, { 0.4, 0.4 } };
+        AABB wide = { { -2.5, 0.0 }, { 2.5, 0.5 } };
+        AABB huge = { { -500, -1 }, { 500, 0 } };
+        AABB far = { { 10, 10 }, { 11, 11 } };
+
+        grid.insert(0, huge);
+        grid.insert(1, far);
+        grid.insert(2, wide);
+        grid.insert(3, small);
+
+        std::vector<uint32_t> found;
+
+        //Overlapping bounds only, each once, in index order
+        AABB area = { { 0.0, -0.5 }, { 1.5, 1.5 } };
+        grid.query(area, found);
+        assert_equal(3, found.size());
+        assert_equal(0, found[0]);
+        assert_equal(2, found[1]);
+        assert_equal(3, found[2]);
+
+        //Sharing a cell isn't enough
+        AABB corner = { { 0.6, 0.6 }, { 0.9, 0.9 } };
+        grid.query(corner, found);
+        assert_true(found.empty());
+
+        //Queries bigger than the grid still work
+        AABB everything = { { -1000, -1000 }, { 1000, 1000 } };
+        grid.query(everything, found);
+        assert_equal(4, found.size());
+
+        //Removed items are gone from every cell they covered, moving one is remove and insert
+        grid.remove(2);
+        grid.remove(0);
+        grid.query(area, found);
+        assert_equal(1, found.size());
+        assert_equal(3, found[0]);
+
+        AABB moved = { { 10.5, 10.5 }, { 10.8, 10.8 } };
+        grid.remove(3);
+        grid.insert(3, moved);
+        grid.query(far, found);
+        assert_equal(2, found.size());
+        assert_equal(1, found[0]);
+        assert_equal(3, found[1]);
+
+        grid.clear();
+        grid.query(everything, found);
+        assert_true(found.empty());
+    }
+
+    void test_segment_surfaces() {
+        RayBox ray_box(nullptr, 0.5f, 1.0f);
+        ray_box.set_position(0, 0.5);
+
+        kmVec2 left = { -5, 0 }, right = { 5, 0 };
+
+        Segment floor;
+        floor.set_points(left, right);
+        assert_close(1.0, floor.normal().y, 0.0001);
+        assert_close(0.0, floor.angle(), 0.0001);
+        assert_equal(0, floor.angle_byte());
+
+        std::vector<Collision> collisions = collide(&ray_box, &floor);
+        assert_equal(2, collisions.size());
+        assert_equal('A', collisions[0].a_ray);
+        assert_equal('B', collisions[1].a_ray);
+        assert_close(0.0, collisions[0].point.y, 0.0001);
+        assert_close(1.0, collisions[0].b_normal.y, 0.0001);
+
+        //From behind, the sensors pass straight through
+        Segment ceiling;
+        ceiling.set_points(right, left);
+        assert_close(180.0, ceiling.angle(), 0.0001);
+        assert_equal(128, ceiling.angle_byte());
+        assert_equal(0, collide(&ray_box, &ceiling).size());
+
+        //A wall facing right, like the left hand wall of a room
+        kmVec2 top = { 0, 5 }, bottom = { 0, -5 };
+        Segment wall;
+        wall.set_points(top, bottom);
+        assert_close(90.0, wall.angle(), 0.0001);
+        assert_equal(64, wall.angle_byte());
+    }
+
+    void test_mesh_surfaces() {
+        //A row of four square tiles, two triangles each
+        std::vector<kmVec2> points;
+        for(uint32_t i = 0; i < 4; ++i) {
+            float x = float(i);
+            kmVec2 tile[6] = {
+                { x, -1 }, { x + 1, -1 }, { x + 1, 0 },
+                { x, -1 }, { x + 1, 0 }, { x, 0 }
+            };
+            points.insert(points.end(), tile, tile + 6);
+        }
+
+        std::vector<Segment> surfaces = mesh_surfaces(&points[0], 8, 0.001f);
+
+        //The inside edges are gone and the straight runs are joined, leaving the four sides
+        assert_equal(4, surfaces.size());
+
+        for(const Segment& surface: surfaces) {
+            //Every surface faces out of the tiles
+            kmVec2 middle, centre = { 2, -0.5 }, outwards;
+            kmVec2MidPointBetween(&middle, &surface.point(0), &surface.point(1));
+            kmVec2Subtract(&outwards, &middle, &centre);
+            assert_true(kmVec2Dot(&outwards, &surface.normal()) > 0);
+
+            float length = kmVec2DistanceBetween(&surface.point(0), &surface.point(1));
+            assert_true(length == 1.0f || length == 4.0f);
+        }
+    }
 private:
 
 };
@@ -0,0 +1,84 @@
+#ifndef TEST_COMPACTION_H
+#define TEST_COMPACTION_H
+
+#include <vector>
+
+#include "world_test_case.h"
+
+class TestGeometryCompaction : public WorldTestCase {
+private:
+    std::vector<SDRayHit> cast_rays(const std::vector<SDRay>& rays) {
+        std::vector<SDRayHit> hits(rays.size());
+        sdWorldRayCastBatch(world_, &rays[0], rays.size(), 0, &hits[0]);
+        return hits;
+    }
+
+public:
+    void test_flat_tiles_are_merged() {
+        //A floor of 16 square tiles, two triangles each, with hairline gaps between them
+        const SDuint tiles = 16;
+        const float gap = 0.0001f;
+
+        for(SDuint i = 0; i < tiles; ++i) {
+            float left = float(i) + ((i % 2) ? gap : 0.0f);
+            float right = float(i + 1);
+
+            kmVec2 points[6] = {
+                { left, -1 }, { right, -1 }, { right, 0 },
+                { left, -1 }, { right, 0 }, { left, 0 }
+            };
+            sdWorldAddMesh(world_, 2, points);
+        }
+
+        std::vector<SDRay> rays;
+        for(SDuint i = 0; i < 160; ++i) {
+            SDRay down;
+            kmVec2Fill(&down.start, 0.05f + (i * 0.1f), 2);
+            kmVec2Fill(&down.dir, 0, -4);
+            rays.push_back(down);
+        }
+
+        SDRay from_left, from_right;
+        kmVec2Fill(&from_left.start, -2, -0.5);
+        kmVec2Fill(&from_left.dir, 20, 0);
+        kmVec2Fill(&from_right.start, 18, -0.5);
+        kmVec2Fill(&from_right.dir, -20, 0);
+        rays.push_back(from_left);
+        rays.push_back(from_right);
+
+        std::vector<SDRayHit> before = cast_rays(rays);
+
+        //The whole floor is one box
+        assert_equal((tiles * 2) - 1, sdWorldCompactGeometry(world_, 0.001));
+
+        std::vector<SDRayHit> after = cast_rays(rays);
+        for(SDuint i = 0; i < rays.size(); ++i) {
+            assert_true(before[i].hit);
+            assert_equal(before[i].hit, after[i].hit);
+            assert_close(before[i].point.x, after[i].point.x, 0.001);
+            assert_close(before[i].point.y, after[i].point.y, 0.001);
+            assert_close(before[i].normal.x, after[i].normal.x, 0.001);
+            assert_close(before[i].normal.y, after[i].normal.y, 0.001);
+        }
+
+        //Nothing left to merge
+        assert_equal(0, sdWorldCompactGeometry(world_, 0.001));
+    }
+
+    void test_curves_are_left_alone() {
+        sdWorldConstructLoop(world_, 0, 10, 10);
+        assert_equal(0, sdWorldCompactGeometry(world_, 0.001));
+    }
+
+    void test_slivers_are_removed() {
+        kmVec2 sliver[] = { { 0, 0 }, { 5, 0 }, { 2, 0.0001 } };
+        sdWorldAddTriangle(world_, sliver);
+
+        kmVec2 triangle[] = { { 0, 2 }, { 5, 2 }, { 2, 4 } };
+        sdWorldAddTriangle(world_, triangle);
+
+        assert_equal(1, sdWorldCompactGeometry(world_, 0.001));
+    }
+};
+
+#endif // TEST_COMPACTION_H
@@ -0,0 +1,108 @@
+#ifndef TEST_PHYSICS_THREAD_H
+#define TEST_PHYSICS_THREAD_H
+
+#include <atomic>
+#include <thread>
+
+#include "world_test_case.h"
+
+class TestPhysicsThread : public WorldTestCase {
+public:
+    void test_queued_commands_apply_on_update() {
+        SDuint box = sdBoxCreate(world_, 1.0, 1.0);
+        SDuint character = sdCharacterCreate(world_);
+
+        assert_true(sdWorldQueueObjectPosition(world_, box, 10, 0));
+        assert_true(sdWorldQueueObjectSpeed(world_, box, 1, 0));
+
+        SDInputFrame frame = { character, SD_INPUT_RIGHT };
+        assert_equal(1, sdWorldQueueInputs(world_, &frame, 1));
+
+        //Nothing happens until the world updates
+        assert_equal(0, sdObjectGetPositionX(box));
+
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_equal(11, sdObjectGetPositionX(box));
+        assert_true(sdObjectGetSpeedX(character) > 0);
+    }
+
+    void test_full_queue_rejects_commands() {
+        SDuint box = sdBoxCreate(world_, 1.0, 1.0);
+
+        SDuint accepted = 0;
+        while(sdWorldQueueObjectSpeed(world_, box, 1, 0) && accepted < 100000) {
+            ++accepted;
+        }
+
+        assert_true(accepted > 0);
+        assert_true(accepted < 100000);
+
+        //Updating drains the queue
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_true(sdWorldQueueObjectSpeed(world_, box, 1, 0));
+    }
+
+    void test_published_state() {
+        SDuint box = sdBoxCreate(world_, 1.0, 1.0);
+        sdObjectSetSpeedX(box, 1.0);
+
+        SDObjectState states[2];
+
+        //Nothing is published unless it's switched on
+        sdWorldStep(world_, TWORLD::frame_time);
+        sdWorldAcquirePublishedState(world_);
+        assert_equal(0, sdWorldGetPublishedObjectStates(world_, states, 2));
+
+        sdWorldEnableStatePublishing(world_);
+        sdWorldStep(world_, TWORLD::frame_time);
+        sdWorldStep(world_, TWORLD::frame_time);
+
+        //We always get the most recent step
+        assert_equal(3, sdWorldAcquirePublishedState(world_));
+        assert_equal(1, sdWorldGetPublishedObjectStates(world_, states, 2));
+        assert_equal(box, states[0].object);
+        assert_equal(3, states[0].position.x);
+
+        //The snapshot doesn't change under us
+        sdWorldStep(world_, TWORLD::frame_time);
+        sdWorldGetPublishedObjectStates(world_, states, 2);
+        assert_equal(3, states[0].position.x);
+
+        assert_equal(4, sdWorldAcquirePublishedState(world_));
+    }
+
+    void test_update_on_another_thread() {
+        SDuint box = sdBoxCreate(world_, 1.0, 1.0);
+        sdWorldEnableStatePublishing(world_);
+
+        std::atomic<bool> running(true);
+        std::thread physics([&]() {
+            while(running) {
+                sdWorldStep(world_, TWORLD::frame_time);
+            }
+        });
+
+        sdWorldQueueObjectSpeed(world_, box, 1, 0);
+
+        SDuint64 last_step = 0;
+        SDObjectState state;
+        bool moved = false;
+        for(uint32_t i = 0; i < 100000 && !moved; ++i) {
+            SDuint64 step = sdWorldAcquirePublishedState(world_);
+            assert_true(step >= last_step);
+            last_step = step;
+
+            if(sdWorldGetPublishedObjectStates(world_, &state, 1)) {
+                moved = state.position.x > 0;
+            }
+            std::this_thread::yield();
+        }
+
+        running = false;
+        physics.join();
+
+        assert_true(moved);
+    }
+};
+
+#endif // TEST_PHYSICS_THREAD_H
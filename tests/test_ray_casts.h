@@ -0,0 +1,181 @@
+#ifndef TEST_RAY_CASTS_H
+#define TEST_RAY_CASTS_H
+
+#include <vector>
+#include <cmath>
+
+#include "world_test_case.h"
+
+class TestRayCasts : public WorldTestCase {
+public:
+    void set_up() {
+        WorldTestCase::set_up();
+
+        SDVec2 floor[] = {
+            { -10, -1 }, { 10, -1 }, { 10, 0 }, { -10, 0 }
+        };
+        sdWorldAddBox(world_, floor);
+    }
+
+    void test_ray_cast_hits_static_geometry() {
+        SDRay ray;
+        kmVec2Fill(&ray.start, 0, 4);
+        kmVec2Fill(&ray.dir, 0, -8);
+
+        SDRayHit hit;
+        assert_true(sdWorldRayCast(world_, &ray, 0, &hit));
+        assert_true(hit.hit);
+        assert_equal(SD_QUERY_HIT_BOX, hit.type); //The floor
+        assert_equal(0, hit.id);
+        assert_close(0.0, hit.point.y, 0.0001);
+        assert_close(1.0, hit.normal.y, 0.0001);
+        assert_close(0.5, hit.fraction, 0.0001);
+
+        //Too short to reach the floor
+        kmVec2Fill(&ray.dir, 0, -2);
+        assert_false(sdWorldRayCast(world_, &ray, 0, &hit));
+        assert_false(hit.hit);
+    }
+
+    void test_ray_cast_hits_nearest_object() {
+        SDuint box = sdBoxCreate(world_, 1.0, 1.0);
+        sdObjectSetPosition(box, 0, 2);
+
+        SDuint trigger = sdTriggerCreate(world_, 1.0, 1.0);
+        sdObjectSetPosition(trigger, 0, 3);
+
+        SDRay ray;
+        kmVec2Fill(&ray.start, 0, 4);
+        kmVec2Fill(&ray.dir, 0, -8);
+
+        SDRayHit hit;
+        assert_true(sdWorldRayCast(world_, &ray, 0, &hit));
+        assert_equal(SD_QUERY_HIT_OBJECT, hit.type);
+        assert_equal(box, hit.id); //Straight through the trigger
+        assert_close(2.5, hit.point.y, 0.0001);
+
+        //Looking from inside the box, it's ignored
+        kmVec2Fill(&ray.start, 0, 2);
+        assert_true(sdWorldRayCast(world_, &ray, box, &hit));
+        assert_equal(SD_QUERY_HIT_BOX, hit.type);
+        assert_close(0.0, hit.point.y, 0.0001);
+    }
+
+    void test_rays_only_hit_the_front_of_geometry() {
+        //A ledge facing up at y = 2, and a triangle above it
+        kmVec2 ledge[] = { { -1, 2 }, { 1, 2 } };
+        sdWorldAddSegment(world_, ledge);
+
+        kmVec2 triangle[] = { { -1, 5 }, { 1, 5 }, { 0, 6 } };
+        sdWorldAddTriangle(world_, triangle);
+
+        SDRay ray;
+        kmVec2Fill(&ray.start, 0, 4);
+        kmVec2Fill(&ray.dir, 0, -8);
+
+        SDRayHit hit;
+        assert_true(sdWorldRayCast(world_, &ray, 0, &hit));
+        assert_equal(SD_QUERY_HIT_SEGMENT, hit.type);
+        assert_equal(0, hit.id);
+        assert_close(2.0, hit.point.y, 0.0001);
+        assert_close(1.0, hit.normal.y, 0.0001);
+
+        //Up through the back of the ledge, into the bottom of the triangle
+        kmVec2Fill(&ray.start, 0, 1);
+        kmVec2Fill(&ray.dir, 0, 8);
+        assert_true(sdWorldRayCast(world_, &ray, 0, &hit));
+        assert_equal(SD_QUERY_HIT_TRIANGLE, hit.type);
+        assert_equal(0, hit.id);
+        assert_close(5.0, hit.point.y, 0.0001);
+        assert_close(-1.0, hit.normal.y, 0.0001);
+        assert_close(0.5, hit.fraction, 0.0001);
+
+        //Starting inside the triangle, there's nothing to hit on the way out
+        kmVec2Fill(&ray.start, 0, 5.5);
+        kmVec2Fill(&ray.dir, 0, 4);
+        assert_false(sdWorldRayCast(world_, &ray, 0, &hit));
+    }
+
+    void test_batch_matches_single_casts() {
+        sdWorldConstructLoop(world_, 2, 10, 6);
+
+        SDuint box = sdBoxCreate(world_, 1.0, 1.0);
+        sdObjectSetPosition(box, -3, 2);
+
+        //A fan of rays, neighbours go the same way
+        std::vector<SDRay> rays(500);
+        for(uint32_t i = 0; i < rays.size(); ++i) {
+            float angle = (float(i) / rays.size()) * 2.0f * M_PI;
+            kmVec2Fill(&rays[i].start, 0, 3);
+            kmVec2Fill(&rays[i].dir, std::cos(angle) * 12.0f, std::sin(angle) * 12.0f);
+        }
+
+        std::vector<SDRayHit> hits(rays.size());
+        SDuint count = sdWorldRayCastBatch(world_, &rays[0], rays.size(), 0, &hits[0]);
+        assert_true(count > 0);
+
+        SDuint expected_count = 0;
+        for(uint32_t i = 0; i < rays.size(); ++i) {
+            SDRayHit single;
+            if(sdWorldRayCast(world_, &rays[i], 0, &single)) {
+                ++expected_count;
+            }
+
+            assert_equal(single.hit, hits[i].hit);
+            assert_equal(single.type, hits[i].type);
+            assert_equal(single.id, hits[i].id);
+            assert_equal(single.fraction, hits[i].fraction);
+        }
+
+        assert_equal(expected_count, count);
+    }
+
+    void test_query_aabb() {
+        SDuint near = sdBoxCreate(world_, 1.0, 1.0);
+        sdObjectSetPosition(near, 1, 1);
+
+        SDuint far = sdBoxCreate(world_, 1.0, 1.0);
+        sdObjectSetPosition(far, 8, 1);
+
+        SDVec2 min = { 0, 0.25 };
+        SDVec2 max = { 2, 2 };
+
+        SDQueryHit found[4];
+        assert_equal(1, sdWorldQueryAABB(world_, &min, &max, found, 4));
+        assert_equal(SD_QUERY_HIT_OBJECT, found[0].type);
+        assert_equal(near, found[0].id);
+
+        //Static geometry comes first
+        min.y = -0.5;
+        max.x = 10;
+        assert_equal(3, sdWorldQueryAABB(world_, &min, &max, found, 4));
+        assert_equal(SD_QUERY_HIT_BOX, found[0].type);
+        assert_equal(0, found[0].id);
+        assert_equal(near, found[1].id);
+        assert_equal(far, found[2].id);
+        assert_equal(1, sdWorldQueryAABB(world_, &min, &max, found, 1)); //Only capacity are written
+
+        //Moving an object between steps is seen straight away
+        sdObjectSetPosition(far, 50, 1);
+        assert_equal(2, sdWorldQueryAABB(world_, &min, &max, found, 4));
+    }
+
+    void test_query_aabb_finds_sleeping_objects() {
+        sdWorldEnableSleeping(world_);
+        sdWorldSetSleepParameters(world_, 0.001, 1);
+
+        SDuint sleeper = sdBoxCreate(world_, 1.0, 1.0);
+        sdObjectSetPosition(sleeper, 3, 0.5);
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_true(sdObjectIsSleeping(sleeper));
+
+        SDVec2 min = { 2, 0.25 };
+        SDVec2 max = { 4, 1 };
+
+        SDQueryHit found[2];
+        assert_equal(1, sdWorldQueryAABB(world_, &min, &max, found, 2));
+        assert_equal(sleeper, found[0].id);
+    }
+};
+
+#endif // TEST_RAY_CASTS_H
@@ -68,6 +68,227 @@ public:
     void test_response_hazard() {
 
     }
+
+    void test_collision_events_use_response_table() {
+        bool collided = false;
+
+        SDuint world = sdWorldCreate();
+        sdWorldSetObjectCollisionCallback(world, &spring_low_response, (void*)&collided);
+        sdWorldEnableCollisionEvents(world);
+
+        SDuint box1 = sdBoxCreate(world, 1.0, 1.0);
+        sdObjectSetPosition(box1, 0, -1);
+        sdObjectSetFixed(box1, true);
+
+        SDuint box2 = sdBoxCreate(world, 1.0, 1.0);
+        sdObjectSetPosition(box2, 0, 0);
+
+        //Set in the opposite order to how the pair is tested
+        sdWorldSetCollisionResponse(world, box2, box1, COLLISION_RESPONSE_BOUNCE_ONE, COLLISION_RESPONSE_NONE);
+
+        sdWorldStep(world, 0.1);
+
+        assert_false(collided); //The callback is never called while events are enabled
+        assert_close(6.5 / 40.0, sdObjectGetSpeedY(box2), 0.0001);
+        assert_equal(0, sdObjectGetSpeedY(box1));
+
+        SDCollisionEvent events[2];
+        assert_equal(1, sdWorldGetCollisionEvents(world, events, 2));
+        assert_equal(box1, events[0].lhs);
+        assert_equal(box2, events[0].rhs);
+        assert_close(1.0, events[0].normal.y, 0.0001);
+        assert_close(-0.5, events[0].point.y, 0.0001);
+
+        //Events only cover the last step
+        sdObjectSetPosition(box2, 0, 5);
+        sdWorldStep(world, 0.1);
+        assert_equal(0, sdWorldGetCollisionEventCount(world));
+
+        sdWorldDestroy(world);
+    }
+
+    void test_boxes_rest_on_floor_and_stack() {
+        SDuint world = sdWorldCreate();
+
+        SDVec2 floor[] = {
+            { -10, -1 }, { 10, -1 }, { 10, 0 }, { -10, 0 }
+        };
+        sdWorldAddBox(world, floor);
+
+        SDuint bottom = sdBoxCreate(world, 1.0, 1.0);
+        sdObjectSetPosition(bottom, 0, 0.5);
+        sdBoxSetGravityEnabled(bottom, true);
+
+        SDuint top = sdBoxCreate(world, 1.0, 1.0);
+        sdObjectSetPosition(top, 0.2, 1.6);
+        sdBoxSetGravityEnabled(top, true);
+
+        for(uint32_t i = 0; i < 300; ++i) {
+            sdWorldStep(world, 1.0 / 60.0);
+        }
+
+        //Both boxes have come to rest, one on top of the other
+        assert_close(0.5, sdObjectGetPositionY(bottom), 0.05);
+        assert_close(1.5, sdObjectGetPositionY(top), 0.1);
+        assert_close(0, sdObjectGetSpeedY(bottom), 0.001);
+        assert_close(0, sdObjectGetSpeedY(top), 0.001);
+
+        sdWorldDestroy(world);
+    }
+
+    void test_type_responses() {
+        SDuint world = sdWorldCreate();
+
+        const SDuint BALL = 1;
+        const SDuint BUMPER = 2;
+
+        //Bumpers throw balls sideways, the bumper itself gets the default response
+        sdWorldSetTypeResponse(world, BALL, BUMPER, COLLISION_RESPONSE_BUMPER, 0.5, 90);
+
+        SDuint bumper = sdCircleCreate(world, 1.0);
+        sdObjectSetFixed(bumper, true);
+        sdObjectSetType(bumper, BUMPER);
+
+        SDuint ball = sdCircleCreate(world, 1.0);
+        sdObjectSetPosition(ball, 0.1, 0.9);
+        sdObjectSetType(ball, BALL);
+        assert_equal(BALL, sdObjectGetType(ball));
+
+        sdWorldStep(world, 1.0 / 60.0);
+
+        assert_close(0.5, sdObjectGetSpeedX(ball), 0.0001);
+        assert_close(0.0, sdObjectGetSpeedY(ball), 0.0001);
+        assert_equal(0, sdObjectGetSpeedX(bumper));
+
+        //Responses for the pair override the type rules
+        sdObjectSetPosition(ball, 0.1, 0.9);
+        sdObjectSetSpeedX(ball, 0);
+        sdWorldSetCollisionResponse(world, ball, bumper, COLLISION_RESPONSE_BOUNCE_TWO, COLLISION_RESPONSE_NONE);
+        sdWorldStep(world, 1.0 / 60.0);
+        assert_close(7.5 / 40.0, sdObjectGetSpeedY(ball), 0.0001);
+
+        //Untyped objects never match a rule
+        sdWorldClearCollisionResponses(world);
+        sdObjectSetType(ball, 0);
+        sdObjectSetPosition(ball, 0.1, 0.9);
+        sdObjectSetSpeedY(ball, 0);
+        sdWorldStep(world, 1.0 / 60.0);
+        assert_equal(0, sdObjectGetSpeedX(ball));
+
+        sdWorldDestroy(world);
+    }
+
+    void test_circles_rest_on_floor_and_each_other() {
+        SDuint world = sdWorldCreate();
+
+        SDVec2 floor[] = {
+            { -10, -1 }, { 10, -1 }, { 10, 0 }, { -10, 0 }
+        };
+        sdWorldAddBox(world, floor);
+
+        SDuint bottom = sdCircleCreate(world, 1.0);
+        sdObjectSetPosition(bottom, 0, 0.6);
+        sdCircleSetGravityEnabled(bottom, true);
+
+        SDuint top = sdCircleCreate(world, 1.0);
+        sdObjectSetPosition(top, 0, 1.7);
+        sdCircleSetGravityEnabled(top, true);
+
+        SDuint ring = sdCircleCreate(world, 0.5);
+        sdObjectSetPosition(ring, 5, 5); //Rings float
+
+        for(uint32_t i = 0; i < 300; ++i) {
+            sdWorldStep(world, 1.0 / 60.0);
+        }
+
+        assert_close(0.5, sdObjectGetPositionY(bottom), 0.05);
+        assert_close(1.5, sdObjectGetPositionY(top), 0.1);
+        assert_close(0, sdObjectGetSpeedY(top), 0.001);
+        assert_equal(5, sdObjectGetPositionY(ring));
+
+        sdWorldDestroy(world);
+    }
+
+    void test_character_stands_on_another_character() {
+        SDuint world = sdWorldCreate();
+
+        SDVec2 floor[] = {
+            { -10, -1 }, { 10, -1 }, { 10, 0 }, { -10, 0 }
+        };
+        sdWorldAddBox(world, floor);
+
+        SDuint bottom = sdCharacterCreate(world);
+        sdObjectSetPosition(bottom, 0, 0.5);
+
+        SDuint top = sdCharacterCreate(world);
+        sdObjectSetPosition(top, 0.1, 1.6);
+
+        for(uint32_t i = 0; i < 60; ++i) {
+            sdWorldStep(world, 1.0 / 60.0);
+        }
+
+        //The top character lands on the head of the bottom one
+        assert_close(0.5, sdObjectGetPositionY(bottom), 0.001);
+        assert_close(1.5, sdObjectGetPositionY(top), 0.001);
+        assert_true(sdCharacterIsGrounded(top));
+
+        sdWorldDestroy(world);
+    }
+
+    void test_objects_land_on_surfaces() {
+        SDuint world = sdWorldCreate();
+
+        //A floor made of two tiles, converted to the one surface along the top
+        SDVec2 floor[] = {
+            { -10, -1 }, { 0, -1 }, { 0, 0 },
+            { -10, -1 }, { 0, 0 }, { -10, 0 },
+            { 0, -1 }, { 10, -1 }, { 10, 0 },
+            { 0, -1 }, { 10, 0 }, { 0, 0 }
+        };
+        sdWorldAddMeshSurfaces(world, 4, floor);
+
+        SDuint character = sdCharacterCreate(world);
+        sdObjectSetPosition(character, 0, 1.0);
+
+        SDuint box = sdBoxCreate(world, 1.0, 1.0);
+        sdObjectSetPosition(box, 3, 1.0);
+        sdBoxSetGravityEnabled(box, true);
+
+        SDuint circle = sdCircleCreate(world, 1.0);
+        sdObjectSetPosition(circle, -3, 1.0);
+        sdCircleSetGravityEnabled(circle, true);
+
+        for(uint32_t i = 0; i < 60; ++i) {
+            sdWorldStep(world, 1.0 / 60.0);
+        }
+
+        assert_close(0.5, sdObjectGetPositionY(character), 0.001);
+        assert_true(sdCharacterIsGrounded(character));
+        assert_close(0.5, sdObjectGetPositionY(box), 0.02);
+        assert_close(0.5, sdObjectGetPositionY(circle), 0.02);
+
+        sdWorldDestroy(world);
+    }
+
+    void test_surfaces_are_one_sided() {
+        SDuint world = sdWorldCreate();
+
+        //Facing down, so it's a ceiling that things can fall through from above
+        SDVec2 ceiling[] = { { 10, 0 }, { -10, 0 } };
+        sdWorldAddSegment(world, ceiling);
+
+        SDuint character = sdCharacterCreate(world);
+        sdObjectSetPosition(character, 0, 1.0);
+
+        for(uint32_t i = 0; i < 60; ++i) {
+            sdWorldStep(world, 1.0 / 60.0);
+        }
+
+        assert_true(sdObjectGetPositionY(character) < -0.5);
+        assert_false(sdCharacterIsGrounded(character));
+
+        sdWorldDestroy(world);
+    }
 };
 
 #endif // TEST_RESPONSE_H
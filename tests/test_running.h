@@ -172,6 +172,40 @@ public:
 
         sdWorldDestroy(world);
     }
+
+    void test_profiles() {
+        SDuint world = sdWorldCreate();
+        SDuint sonic = sdCharacterCreate(world);
+        SDuint super_sonic = sdCharacterCreate(world);
+        sdCharacterSetProfilePreset(super_sonic, SD_PROFILE_SUPER);
+
+        SDCharacterProfile profile;
+        sdCharacterGetProfile(super_sonic, &profile);
+        assert_close(10.0f * TR::world_scale, profile.top_speed, TR::EPSILON);
+
+        sdCharacterRightPressed(sonic);
+        sdCharacterRightPressed(super_sonic);
+        sdWorldStep(world, TR::frame_time);
+
+        assert_true(sdObjectGetSpeedX(super_sonic) > sdObjectGetSpeedX(sonic));
+
+        //Tuning a single value only changes that character
+        sdCharacterGetProfile(sonic, &profile);
+        profile.acceleration = 0;
+        sdCharacterSetProfile(sonic, &profile);
+
+        float speed = sdObjectGetSpeedX(sonic);
+        sdCharacterRightPressed(sonic);
+        sdWorldStep(world, TR::frame_time);
+        assert_close(speed, sdObjectGetSpeedX(sonic), TR::EPSILON);
+
+        //Presets that don't exist fall back to Sonic
+        sdCharacterSetProfilePreset(super_sonic, SDProfilePreset(SD_PROFILE_SUPER + 1));
+        sdCharacterGetProfile(super_sonic, &profile);
+        assert_close(6.0f * TR::world_scale, profile.top_speed, TR::EPSILON);
+
+        sdWorldDestroy(world);
+    }
 };
 
 #endif // TEST_RUNNING_H
@@ -0,0 +1,127 @@
+#ifndef TEST_SLEEPING_H
+#define TEST_SLEEPING_H
+
+#include "world_test_case.h"
+
+class TestSleeping : public WorldTestCase {
+public:
+    void test_sleeping_disabled_by_default() {
+        SDuint box = sdBoxCreate(world_, 1.0, 1.0);
+
+        for(uint32_t i = 0; i < 120; ++i) {
+            sdWorldStep(world_, TWORLD::frame_time);
+        }
+
+        assert_false(sdObjectIsSleeping(box));
+    }
+
+    void test_idle_objects_fall_asleep() {
+        sdWorldEnableSleeping(world_);
+        sdWorldSetSleepParameters(world_, 0.001, 10);
+
+        SDuint box = sdBoxCreate(world_, 1.0, 1.0);
+
+        for(uint32_t i = 0; i < 9; ++i) {
+            sdWorldStep(world_, TWORLD::frame_time);
+            assert_false(sdObjectIsSleeping(box));
+        }
+
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_true(sdObjectIsSleeping(box));
+
+        //Disabling sleeping wakes everything up
+        sdWorldDisableSleeping(world_);
+        assert_false(sdObjectIsSleeping(box));
+    }
+
+    void test_setting_speed_or_position_wakes() {
+        sdWorldEnableSleeping(world_);
+        sdWorldSetSleepParameters(world_, 0.001, 1);
+
+        SDuint box = sdBoxCreate(world_, 1.0, 1.0);
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_true(sdObjectIsSleeping(box));
+
+        sdObjectSetSpeedX(box, 1.0);
+        assert_false(sdObjectIsSleeping(box));
+
+        sdObjectSetSpeedX(box, 0.0);
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_true(sdObjectIsSleeping(box));
+
+        sdObjectSetPosition(box, 10, 10);
+        assert_false(sdObjectIsSleeping(box));
+    }
+
+    void test_sleeping_objects_dont_move() {
+        sdWorldEnableSleeping(world_);
+        sdWorldSetSleepParameters(world_, 0.5, 1);
+
+        SDuint box = sdBoxCreate(world_, 1.0, 1.0);
+        sdObjectSetSpeedX(box, 0.25); //Under the threshold
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_true(sdObjectIsSleeping(box));
+
+        float x = sdObjectGetPositionX(box);
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_equal(x, sdObjectGetPositionX(box));
+    }
+
+    void test_moving_objects_wake_sleepers() {
+        sdWorldEnableSleeping(world_);
+        sdWorldSetSleepParameters(world_, 0.001, 2);
+
+        SDuint sleeper = sdBoxCreate(world_, 1.0, 1.0);
+        sdObjectSetPosition(sleeper, 0, 0);
+        sdWorldStep(world_, TWORLD::frame_time);
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_true(sdObjectIsSleeping(sleeper));
+
+        SDuint mover = sdBoxCreate(world_, 1.0, 1.0);
+        sdObjectSetPosition(mover, 3, 0);
+        sdObjectSetSpeedX(mover, -1.0);
+
+        //Still too far away to touch the sleeper this step
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_true(sdObjectIsSleeping(sleeper));
+
+        //But now it'll reach it
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_false(sdObjectIsSleeping(sleeper));
+    }
+
+    void test_sleepers_are_still_woken_after_objects_are_destroyed() {
+        sdWorldEnableSleeping(world_);
+        sdWorldSetSleepParameters(world_, 0.001, 1);
+
+        SDuint doomed = sdBoxCreate(world_, 1.0, 1.0);
+        sdObjectSetPosition(doomed, -20, 0);
+
+        SDuint sleeper = sdBoxCreate(world_, 1.0, 1.0);
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_true(sdObjectIsSleeping(sleeper));
+
+        //Everything after the destroyed object moves down a place
+        sdObjectDestroy(doomed);
+
+        SDuint mover = sdBoxCreate(world_, 1.0, 1.0);
+        sdObjectSetPosition(mover, 1.5, 0);
+        sdObjectSetSpeedX(mover, -1.0);
+
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_false(sdObjectIsSleeping(sleeper));
+    }
+
+    void test_airborne_characters_stay_awake() {
+        sdWorldEnableSleeping(world_);
+        sdWorldSetSleepParameters(world_, 0.001, 1);
+
+        SDuint character = sdCharacterCreate(world_);
+
+        //Characters in the air never sleep
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_false(sdObjectIsSleeping(character));
+    }
+};
+
+#endif // TEST_SLEEPING_H
@@ -180,6 +180,22 @@ public:
         assert_close(-36, ray_box.ray('D').dir.y, 0.001);
     }
 
+    void test_rotated_sensors_follow_position() {
+        Character character(nullptr, 20, 40);
+        character.set_quadrant(QUADRANT_CEILING);
+        character.set_position(100, 50);
+
+        const RayBox& ray_box = character.ray_box();
+
+        //The rotation is baked into the sensors, moving just offsets them
+        assert_close(109, ray_box.ray('A').start.x, 0.001);
+        assert_close(50, ray_box.ray('A').start.y, 0.001);
+        assert_close(36, ray_box.ray('A').dir.y, 0.001);
+
+        //Characters of the same size share their sensor layouts
+        assert_true(SensorTemplate::get(20, 72, 180) == SensorTemplate::get(20, 72, 180));
+    }
+
     void test_ground_state() {
         /**
          * Tests the ground state flag. We use an additional central ray that doesn't exist in
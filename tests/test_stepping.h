@@ -0,0 +1,93 @@
+#ifndef TEST_STEPPING_H
+#define TEST_STEPPING_H
+
+#include "world_test_case.h"
+
+class TestFixedStepping : public WorldTestCase {
+public:
+    void test_variable_stepping_by_default() {
+        sdWorldStep(world_, TWORLD::frame_time * 0.5);
+        sdWorldStep(world_, TWORLD::frame_time * 3);
+
+        assert_equal(2, sdWorldGetStepCounter(world_));
+        assert_equal(1.0f, sdWorldGetInterpolationAlpha(world_));
+    }
+
+    void test_time_is_accumulated() {
+        sdWorldSetFixedTimeStep(world_, TWORLD::frame_time, 5);
+
+        //Half a frame isn't enough to run an update
+        sdWorldStep(world_, TWORLD::frame_time * 0.5);
+        assert_equal(0, sdWorldGetStepCounter(world_));
+        assert_close(0.5, sdWorldGetInterpolationAlpha(world_), 0.001);
+
+        //But another one and a quarter is
+        sdWorldStep(world_, TWORLD::frame_time * 1.25);
+        assert_equal(1, sdWorldGetStepCounter(world_));
+        assert_close(0.75, sdWorldGetInterpolationAlpha(world_), 0.001);
+
+        sdWorldStep(world_, TWORLD::frame_time * 2);
+        assert_equal(3, sdWorldGetStepCounter(world_));
+    }
+
+    void test_sub_steps_are_limited() {
+        sdWorldSetFixedTimeStep(world_, TWORLD::frame_time, 3);
+
+        //A huge hitch shouldn't make us try to catch up all at once
+        sdWorldStep(world_, 1.0);
+        assert_equal(3, sdWorldGetStepCounter(world_));
+
+        sdWorldStep(world_, 0);
+        assert_equal(3, sdWorldGetStepCounter(world_));
+    }
+
+    void test_interpolated_positions() {
+        sdWorldSetFixedTimeStep(world_, TWORLD::frame_time, 5);
+
+        SDuint box = sdBoxCreate(world_, 1.0, 1.0);
+        sdObjectSetPosition(box, 0, 0);
+        sdObjectSetSpeedX(box, 1.0);
+
+        sdWorldStep(world_, TWORLD::frame_time * 1.5);
+        assert_equal(1, sdObjectGetPositionX(box));
+
+        SDuint objects[2];
+        SDVec2 positions[2];
+        assert_equal(1, sdWorldGetInterpolatedPositions(world_, objects, positions, 2));
+        assert_equal(box, objects[0]);
+        assert_close(0.5, positions[0].x, 0.001);
+        assert_close(0.0, positions[0].y, 0.001);
+    }
+
+    void test_collision_tries_histogram() {
+        SDVec2 floor[] = {
+            { -10, -1 }, { 10, -1 }, { 10, 0 }, { -10, 0 }
+        };
+        sdWorldAddBox(world_, floor);
+
+        SDuint character = sdCharacterCreate(world_);
+        sdObjectSetPosition(character, 0, 0.5);
+
+        for(uint32_t i = 0; i < 10; ++i) {
+            sdWorldStep(world_, TWORLD::frame_time);
+        }
+
+        SDuint64 histogram[16];
+        assert_equal(11, sdWorldGetCollisionTriesHistogram(world_, histogram, 16));
+
+        //Every update is counted once, and standing still on a floor settles straight away
+        SDuint64 total = 0;
+        for(uint32_t i = 0; i < 11; ++i) {
+            total += histogram[i];
+        }
+        assert_equal(10, total);
+        assert_equal(0, histogram[10]);
+        assert_true(histogram[0] + histogram[1] == 10);
+
+        sdWorldResetCollisionTriesHistogram(world_);
+        sdWorldGetCollisionTriesHistogram(world_, histogram, 16);
+        assert_equal(0, histogram[0]);
+    }
+};
+
+#endif // TEST_STEPPING_H
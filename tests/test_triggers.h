@@ -0,0 +1,70 @@
+#ifndef TEST_TRIGGERS_H
+#define TEST_TRIGGERS_H
+
+#include "world_test_case.h"
+
+class TestTriggers : public WorldTestCase {
+public:
+    void test_enter_stay_and_exit_events() {
+        SDuint trigger = sdTriggerCreate(world_, 1.0, 1.0);
+        SDuint box = sdBoxCreate(world_, 0.5, 0.5);
+        sdObjectSetPosition(box, 5, 0);
+
+        SDTriggerEvent events[4];
+
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_equal(0, sdWorldGetTriggerEventCount(world_));
+
+        sdObjectSetPosition(box, 0.5, 0);
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_equal(1, sdWorldGetTriggerEvents(world_, events, 4));
+        assert_equal(trigger, events[0].trigger);
+        assert_equal(box, events[0].object);
+        assert_equal(SD_TRIGGER_ENTER, events[0].type);
+
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_equal(1, sdWorldGetTriggerEvents(world_, events, 4));
+        assert_equal(SD_TRIGGER_STAY, events[0].type);
+
+        sdObjectSetPosition(box, 5, 0);
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_equal(1, sdWorldGetTriggerEvents(world_, events, 4));
+        assert_equal(SD_TRIGGER_EXIT, events[0].type);
+
+        sdWorldStep(world_, TWORLD::frame_time);
+        assert_equal(0, sdWorldGetTriggerEventCount(world_));
+    }
+
+    void test_triggers_do_not_collide() {
+        SDuint trigger = sdTriggerCreate(world_, 1.0, 1.0);
+
+        SDuint box = sdBoxCreate(world_, 0.5, 0.5);
+        sdObjectSetPosition(box, -0.5, 0);
+        sdObjectSetSpeedX(box, 0.1);
+
+        sdWorldStep(world_, TWORLD::frame_time);
+
+        //The box passes straight through, and the trigger stays put
+        assert_close(-0.4, sdObjectGetPositionX(box), 0.0001);
+        assert_close(0.1, sdObjectGetSpeedX(box), 0.0001);
+        assert_equal(0, sdObjectGetPositionX(trigger));
+        assert_equal(1, sdWorldGetTriggerEventCount(world_));
+    }
+
+    void test_events_from_every_sub_step_are_kept() {
+        sdWorldSetFixedTimeStep(world_, TWORLD::frame_time, 5);
+
+        sdTriggerCreate(world_, 1.0, 1.0);
+        sdBoxCreate(world_, 0.5, 0.5);
+
+        //Two sub-steps, the box enters on the first and stays on the second
+        sdWorldStep(world_, TWORLD::frame_time * 2.5);
+
+        SDTriggerEvent events[4];
+        assert_equal(2, sdWorldGetTriggerEvents(world_, events, 4));
+        assert_equal(SD_TRIGGER_ENTER, events[0].type);
+        assert_equal(SD_TRIGGER_STAY, events[1].type);
+    }
+};
+
+#endif // TEST_TRIGGERS_H
@@ -0,0 +1,223 @@
+#ifndef TEST_WORLDS_H
+#define TEST_WORLDS_H
+
+#include <thread>
+
+#include "world_test_case.h"
+#include "spindash/world.h"
+
+class TestWorlds : public TestCase {
+public:
+    void test_object_ids_belong_to_their_world() {
+        SDuint first = sdWorldCreate();
+        SDuint second = sdWorldCreate();
+
+        SDuint a = sdBoxCreate(first, 1.0, 1.0);
+        SDuint b = sdBoxCreate(second, 1.0, 1.0);
+
+        assert_true(a != b);
+        assert_equal(first, world_of_object(a));
+        assert_equal(second, world_of_object(b));
+
+        assert_true(Object::get(a)->world() == World::get(first));
+        assert_true(World::get(first)->find_object(b) == nullptr);
+        assert_true(World::get(second)->find_object(b) == Object::get(b));
+
+        //Each world hands out its own IDs
+        assert_equal(object_index(a), object_index(b));
+
+        sdWorldDestroy(first);
+        sdWorldDestroy(second);
+    }
+
+    void test_destroying_a_world_forgets_its_objects() {
+        SDuint world = sdWorldCreate();
+        SDuint box = sdBoxCreate(world, 1.0, 1.0);
+        assert_true(Object::exists(box));
+
+        sdWorldDestroy(world);
+        assert_false(Object::exists(box));
+
+        //The ID isn't handed straight back out, so old handles don't find new objects
+        SDuint next = sdWorldCreate();
+        assert_true(next != world);
+        assert_false(Object::exists(box));
+        sdWorldDestroy(next);
+    }
+
+    void test_destroyed_objects_slots_are_reused() {
+        SDuint world = sdWorldCreate();
+
+        SDuint box = sdBoxCreate(world, 1.0, 1.0);
+        sdObjectDestroy(box);
+
+        SDuint next = sdBoxCreate(world, 1.0, 1.0);
+        assert_equal(object_index(box), object_index(next));
+        assert_true(next != box);
+
+        //The old ID is from an earlier generation, so it doesn't find the new box
+        assert_false(Object::exists(box));
+        assert_true(Object::exists(next));
+
+        sdWorldDestroy(world);
+    }
+
+    void test_worlds_step_on_separate_threads() {
+        const uint32_t world_count = 4;
+
+        SDuint worlds[world_count];
+        SDuint boxes[world_count];
+        for(uint32_t i = 0; i < world_count; ++i) {
+            worlds[i] = sdWorldCreate();
+
+            SDVec2 floor[] = { { -10, -1 }, { 10, -1 }, { 10, 0 }, { -10, 0 } };
+            sdWorldAddBox(worlds[i], floor);
+
+            boxes[i] = sdBoxCreate(worlds[i], 1.0, 1.0);
+            sdObjectSetPosition(boxes[i], 0, 2.0 + i);
+            sdBoxSetGravityEnabled(boxes[i], true);
+        }
+
+        std::vector<std::thread> threads;
+        for(uint32_t i = 0; i < world_count; ++i) {
+            SDuint world = worlds[i];
+            threads.push_back(std::thread([world]() {
+                for(uint32_t step = 0; step < 120; ++step) {
+                    sdWorldStep(world, TWORLD::frame_time);
+                }
+            }));
+        }
+
+        for(std::thread& thread: threads) {
+            thread.join();
+        }
+
+        for(uint32_t i = 0; i < world_count; ++i) {
+            assert_close(0.5, sdObjectGetPositionY(boxes[i]), 0.02);
+            sdWorldDestroy(worlds[i]);
+        }
+    }
+
+    void test_characters_created_on_separate_threads() {
+        const uint32_t world_count = 4;
+
+        SDuint worlds[world_count];
+        for(uint32_t i = 0; i < world_count; ++i) {
+            worlds[i] = sdWorldCreate();
+        }
+
+        //Characters share their sensor layouts between worlds, building them mustn't race
+        std::vector<std::thread> threads;
+        for(uint32_t i = 0; i < world_count; ++i) {
+            SDuint world = worlds[i];
+            threads.push_back(std::thread([world]() {
+                for(uint32_t j = 0; j < 50; ++j) {
+                    SDuint character = sdCharacterCreate(world);
+                    sdCharacterDownPressed(character); //Crouching switches to another shape
+                    sdWorldStep(world, TWORLD::frame_time);
+                }
+            }));
+        }
+
+        for(std::thread& thread: threads) {
+            thread.join();
+        }
+
+        for(uint32_t i = 0; i < world_count; ++i) {
+            SDObjectState states[60];
+            assert_equal(50, sdWorldGetObjectStates(worlds[i], states, 60));
+            sdWorldDestroy(worlds[i]);
+        }
+    }
+
+    void test_clones_carry_on_from_the_same_state() {
+        SDuint world = sdWorldCreate();
+
+        SDVec2 floor[] = { { -50, -1 }, { 50, -1 }, { 50, 0 }, { -50, 0 } };
+        sdWorldAddBox(world, floor);
+
+        SDuint character = sdCharacterCreate(world);
+        sdObjectSetPosition(character, 0, 0.5);
+
+        SDuint box = sdBoxCreate(world, 1.0, 1.0);
+        sdObjectSetPosition(box, 3, 4);
+        sdBoxSetGravityEnabled(box, true);
+
+        SDInputFrame right = { character, SD_INPUT_RIGHT };
+        for(uint32_t i = 0; i < 30; ++i) {
+            sdWorldSubmitInputs(world, &right, 1);
+            sdWorldStep(world, TWORLD::frame_time);
+        }
+
+        SDuint clone = sdWorldClone(world);
+        assert_true(clone != 0);
+
+        SDuint cloned_character = sdWorldGetClonedObject(clone, character);
+        SDuint cloned_box = sdWorldGetClonedObject(clone, box);
+        assert_equal(clone, world_of_object(cloned_character));
+        assert_equal(sdObjectGetPositionX(character), sdObjectGetPositionX(cloned_character));
+        assert_equal(sdCharacterGetGroundSpeed(character), sdCharacterGetGroundSpeed(cloned_character));
+
+        //Both worlds given the same input end up in the same place
+        SDInputFrame cloned_right = { cloned_character, SD_INPUT_RIGHT };
+        for(uint32_t i = 0; i < 60; ++i) {
+            sdWorldSubmitInputs(world, &right, 1);
+            sdWorldStep(world, TWORLD::frame_time);
+
+            sdWorldSubmitInputs(clone, &cloned_right, 1);
+            sdWorldStep(clone, TWORLD::frame_time);
+        }
+
+        assert_equal(sdObjectGetPositionX(character), sdObjectGetPositionX(cloned_character));
+        assert_equal(sdObjectGetPositionY(character), sdObjectGetPositionY(cloned_character));
+        assert_equal(sdObjectGetPositionY(box), sdObjectGetPositionY(cloned_box));
+        assert_equal(sdWorldGetStepCounter(world), sdWorldGetStepCounter(clone));
+
+        //Stepping the clone on its own leaves the world alone
+        float x = sdObjectGetPositionX(character);
+        SDInputFrame cloned_left = { cloned_character, SD_INPUT_LEFT };
+        for(uint32_t i = 0; i < 30; ++i) {
+            sdWorldSubmitInputs(clone, &cloned_left, 1);
+            sdWorldStep(clone, TWORLD::frame_time);
+        }
+        assert_equal(x, sdObjectGetPositionX(character));
+        assert_true(sdObjectGetPositionX(cloned_character) != x);
+
+        sdWorldDestroy(clone);
+        assert_equal(x, sdObjectGetPositionX(character));
+        sdWorldDestroy(world);
+    }
+
+    void test_clones_share_geometry_until_it_changes() {
+        SDuint world = sdWorldCreate();
+
+        SDVec2 floor[] = { { -10, -1 }, { 10, -1 }, { 10, 0 }, { -10, 0 } };
+        sdWorldAddBox(world, floor);
+
+        SDuint clone = sdWorldClone(world);
+        assert_true(World::get(world)->get_box_at(0) == World::get(clone)->get_box_at(0));
+
+        //Changing the clone's geometry gives it its own copy first
+        SDVec2 step[] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+        sdWorldAddBox(clone, step);
+
+        assert_equal(1, World::get(world)->get_box_count());
+        assert_equal(2, World::get(clone)->get_box_count());
+        assert_true(World::get(world)->get_box_at(0) != World::get(clone)->get_box_at(0));
+
+        sdWorldDestroy(world);
+
+        //The clone doesn't depend on the world it came from
+        SDuint box = sdBoxCreate(clone, 1.0, 1.0);
+        sdObjectSetPosition(box, 0.5, 3);
+        sdBoxSetGravityEnabled(box, true);
+        for(uint32_t i = 0; i < 120; ++i) {
+            sdWorldStep(clone, TWORLD::frame_time);
+        }
+        assert_close(1.5, sdObjectGetPositionY(box), 0.02);
+
+        sdWorldDestroy(clone);
+    }
+};
+
+#endif // TEST_WORLDS_H
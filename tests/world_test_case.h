@@ -0,0 +1,29 @@
+#ifndef WORLD_TEST_CASE_H
+#define WORLD_TEST_CASE_H
+
+#include <kaztest/kaztest.h>
+
+#include "spindash/spindash.h"
+
+namespace TWORLD {
+    static float frame_time = 1.0f / 60.0f;
+}
+
+/*
+ * For test cases where every test wants an empty world of its own, it's
+ * created before each test and destroyed after it.
+ */
+class WorldTestCase : public TestCase {
+protected:
+    SDuint world_ = 0;
+public:
+    virtual void set_up() {
+        world_ = sdWorldCreate();
+    }
+
+    virtual void tear_down() {
+        sdWorldDestroy(world_);
+    }
+};
+
+#endif // WORLD_TEST_CASE_H